@@ -0,0 +1,324 @@
+// File:   ParseRinexBench.cpp
+// Description:
+// Google Benchmark suite for the observation parser: header parsing, epoch decoding
+// from memory and end-to-end parse_rinex_obs from a file, on synthetic inputs.
+// Every benchmark reports bytes/s, epochs/s and heap allocations per epoch.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+#include <benchmark/benchmark.h>
+
+#include "../include/AsyncReader.hpp"
+#include "../include/CsvWriter.hpp"
+#include "../include/EpochReader.hpp"
+#include "../include/FieldDecoder.hpp"
+#include "../include/LineScan.hpp"
+#include "../include/ParseRinex.hpp"
+#include "../include/ParseStats.hpp"
+#include "RinexGenerator.hpp"
+
+// ---------------------------------------------------------------------------
+// allocation counting: every operator new in this binary goes through here
+
+static std::atomic<uint64_t> g_allocs{0};
+
+// GCC sees the malloc behind an inlined operator new and flags the matching free in
+// operator delete; the pair is consistent, since every allocation comes from here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(n ? n : 1);
+}
+void* operator new[](std::size_t n, const std::nothrow_t& t) noexcept { return operator new(n, t); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+using rinex::bench::GeneratorOptions;
+
+// benchmark arguments: version, interval [s], satellites, obs types, duration [s]
+GeneratorOptions options_from(const benchmark::State& state) {
+  GeneratorOptions opts;
+  opts.version = (int)state.range(0);
+  opts.interval = (double)state.range(1);
+  opts.num_sats = (int)state.range(2);
+  opts.num_obs_types = (int)state.range(3);
+  opts.duration = (double)state.range(4);
+  return opts;
+}
+
+// generated inputs, shared between benchmarks with the same arguments
+struct Input {
+  std::string text;
+  std::string path;
+  size_t header_bytes = 0;
+};
+
+const Input& input_for(const GeneratorOptions& opts) {
+  static std::map<std::tuple<int, double, int, int, double>, Input> cache;
+  auto key = std::make_tuple(opts.version, opts.interval, opts.num_sats, opts.num_obs_types,
+                             opts.duration);
+  auto it = cache.find(key);
+  if (it != cache.end()) return it->second;
+
+  Input& in = cache[key];
+  in.text = rinex::bench::generate_rinex(opts);
+  size_t eoh = in.text.find("END OF HEADER");
+  in.header_bytes = in.text.find('\n', eoh) + 1;
+
+  char name[128];
+  snprintf(name, sizeof(name), "rinex_bench_v%d_%g_%d_%d_%g.rnx", opts.version, opts.interval,
+           opts.num_sats, opts.num_obs_types, opts.duration);
+  const char* tmp = std::getenv("TMPDIR");
+  in.path = std::string(tmp ? tmp : "/tmp") + "/" + name;
+  rinex::bench::write_rinex(in.path, opts);
+  return in;
+}
+
+void report(benchmark::State& state, size_t bytes, size_t epochs, uint64_t allocs) {
+  state.SetBytesProcessed((int64_t)(bytes * state.iterations()));
+  state.counters["epochs/s"] =
+      benchmark::Counter((double)(epochs * state.iterations()), benchmark::Counter::kIsRate);
+  state.counters["allocs/epoch"] =
+      (double)allocs / std::max<double>(1, (double)(epochs * state.iterations()));
+}
+
+void BM_ParseHeader(benchmark::State& state) {
+  const Input& in = input_for(options_from(state));
+  std::string_view text(in.text);
+  uint64_t allocs = 0;
+  for (auto _ : state) {
+    uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+    rinex::LineScanner scanner(text);
+    rinex::RinexHeader hdr;
+    rinex::ParseRinexError rc = rinex::parse_rinex_header(scanner, hdr);
+    benchmark::DoNotOptimize(rc);
+    benchmark::DoNotOptimize(hdr.obs_types.data());
+    allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+  }
+  // per header rather than per epoch: the header is parsed once per file
+  state.SetBytesProcessed((int64_t)(in.header_bytes * state.iterations()));
+  state.counters["allocs/header"] = (double)allocs / (double)state.iterations();
+}
+
+// splitting the whole file into lines, nothing else
+void BM_ScanLines(benchmark::State& state) {
+  const Input& in = input_for(options_from(state));
+  size_t lines = 0;
+  for (auto _ : state) {
+    rinex::LineScanner scanner(in.text);
+    std::string_view line;
+    lines = 0;
+    while (scanner.next(line)) ++lines;
+    benchmark::DoNotOptimize(lines);
+  }
+  state.SetBytesProcessed((int64_t)(in.text.size() * state.iterations()));
+  state.counters["lines/s"] =
+      benchmark::Counter((double)(lines * state.iterations()), benchmark::Counter::kIsRate);
+  state.SetLabel(rinex::line_scan_kernel());
+}
+
+void BM_DecodeEpochs(benchmark::State& state) {
+  const Input& in = input_for(options_from(state));
+  std::string_view text(in.text);
+  rinex::LineScanner scanner(text);
+  rinex::RinexHeader hdr;
+  if (rinex::parse_rinex_header(scanner, hdr) != rinex::ParseRinexError::Success) {
+    state.SkipWithError("header");
+    return;
+  }
+  std::string_view body = text.substr(in.header_bytes);
+  rinex::ObsEpoch epoch;
+  uint64_t allocs = 0;
+  size_t epochs = 0;
+  for (auto _ : state) {
+    uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+    rinex::EpochReader reader;
+    reader.open(body, hdr);
+    epochs = 0;
+    while (reader.next(epoch)) ++epochs;
+    benchmark::DoNotOptimize(epoch.obs.data());
+    allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+  }
+  report(state, body.size(), epochs, allocs);
+  state.SetLabel(rinex::obs_decode_kernel());
+}
+
+// as BM_DecodeEpochs, but converting only two observables (code and phase on L1)
+void BM_DecodeEpochsSelected(benchmark::State& state) {
+  const Input& in = input_for(options_from(state));
+  std::string_view text(in.text);
+  rinex::LineScanner scanner(text);
+  rinex::RinexHeader hdr;
+  if (rinex::parse_rinex_header(scanner, hdr) != rinex::ParseRinexError::Success ||
+      rinex::select_obs_types(hdr, {"C1C", "L1C", "C1", "L1"}) != rinex::ParseRinexError::Success) {
+    state.SkipWithError("header");
+    return;
+  }
+  std::string_view body = text.substr(in.header_bytes);
+  rinex::ObsEpoch epoch;
+  uint64_t allocs = 0;
+  size_t epochs = 0;
+  for (auto _ : state) {
+    uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+    rinex::EpochReader reader;
+    reader.open(body, hdr);
+    epochs = 0;
+    while (reader.next(epoch)) ++epochs;
+    benchmark::DoNotOptimize(epoch.obs.data());
+    allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+  }
+  report(state, body.size(), epochs, allocs);
+}
+
+// End-to-end parse_rinex_obs of a generated file with opts. With upstream set, each
+// result is allocated from a monotonic arena over it that is released after the parse.
+void parse_file(benchmark::State& state, const rinex::ParseOptions& opts,
+                std::pmr::memory_resource* upstream = nullptr) {
+  const Input& in = input_for(options_from(state));
+  uint64_t allocs = 0;
+  size_t epochs = 0;
+  for (auto _ : state) {
+    uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+    std::pmr::monotonic_buffer_resource arena(upstream ? upstream : std::pmr::get_default_resource());
+    rinex::RinexObs obs(upstream ? &arena : std::pmr::get_default_resource());
+    if (rinex::parse_rinex_obs(in.path, obs, opts) != rinex::ParseRinexError::Success) {
+      state.SkipWithError("parse_rinex_obs");
+      return;
+    }
+    epochs = obs.num_epochs();
+    benchmark::DoNotOptimize(obs.obs.data());
+    benchmark::DoNotOptimize(obs.obs_fixed.data());
+    allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+  }
+  report(state, in.text.size(), epochs, allocs);
+}
+
+void BM_ParseFile(benchmark::State& state) { parse_file(state, rinex::ParseOptions()); }
+
+// with ParseStats counting; the difference to BM_ParseFile is the cost of the counters
+void BM_ParseFileStats(benchmark::State& state) {
+  rinex::ParseStats stats;
+  rinex::ParseOptions opts;
+  opts.stats = &stats;
+  parse_file(state, opts);
+}
+
+// with the columns in a monotonic arena released after each parse
+void BM_ParseFileArena(benchmark::State& state) {
+  parse_file(state, rinex::ParseOptions(), std::pmr::new_delete_resource());
+}
+
+// storing the observations as int64 thousandths
+void BM_ParseFileFixedPoint(benchmark::State& state) {
+  rinex::ParseOptions opts;
+  opts.fixed_point = true;
+  parse_file(state, opts);
+}
+
+// reading the file on an I/O thread instead of mapping it
+void BM_ParseFileIoThread(benchmark::State& state) {
+  rinex::ParseOptions opts;
+  opts.io_thread = true;
+  parse_file(state, opts);
+}
+
+// reading the file through an AsyncReader (io_uring or pread)
+void BM_ParseFileAsync(benchmark::State& state) {
+  rinex::AsyncReader io;
+  rinex::ParseOptions opts;
+  opts.async_io = &io;
+  parse_file(state, opts);
+  state.SetLabel(io.backend());
+}
+
+// chunks decoded on one thread per core
+void BM_ParseFileThreaded(benchmark::State& state) {
+  rinex::ParseOptions opts;
+  opts.threads = 0;
+  opts.min_chunk_bytes = 1 << 20;
+  parse_file(state, opts);
+}
+
+// CSV export of a parsed file to /dev/null, so that only the formatting is timed; bytes/s
+// is the rate of CSV text
+void write_csv(benchmark::State& state, unsigned threads) {
+  const Input& in = input_for(options_from(state));
+  rinex::RinexObs obs;
+  if (rinex::parse_rinex_obs(in.path, obs) != rinex::ParseRinexError::Success) {
+    state.SkipWithError("parse_rinex_obs");
+    return;
+  }
+  rinex::CsvOptions copts;
+  copts.threads = threads;
+  std::ostringstream text;
+  rinex::write_obs_csv(text, obs, copts);
+  std::ofstream out("/dev/null", std::ios::binary);
+  uint64_t allocs = 0;
+  for (auto _ : state) {
+    uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+    if (!rinex::write_obs_csv(out, obs, copts)) {
+      state.SkipWithError("write_obs_csv");
+      return;
+    }
+    allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+  }
+  report(state, (size_t)text.tellp(), obs.num_epochs(), allocs);
+}
+
+void BM_WriteCsv(benchmark::State& state) { write_csv(state, 1); }
+void BM_WriteCsvThreaded(benchmark::State& state) { write_csv(state, 0); }
+
+// daily 30 s files, then an hour of 1 Hz data from a multi-GNSS sized receiver
+void shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"ver", "dt", "sats", "types", "len"});
+  b->Args({2, 30, 12, 5, 86400});
+  b->Args({2, 30, 12, 8, 86400});
+  b->Args({3, 30, 12, 8, 86400});
+  b->Args({3, 1, 40, 16, 3600});
+  b->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_ParseHeader)->Apply(shapes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ScanLines)->Apply(shapes);
+BENCHMARK(BM_DecodeEpochs)->Apply(shapes);
+BENCHMARK(BM_DecodeEpochsSelected)->Apply(shapes);
+BENCHMARK(BM_ParseFile)->Apply(shapes);
+BENCHMARK(BM_ParseFileStats)->Apply(shapes);
+BENCHMARK(BM_ParseFileArena)->Apply(shapes);
+BENCHMARK(BM_ParseFileFixedPoint)->Apply(shapes);
+BENCHMARK(BM_ParseFileIoThread)->Apply(shapes)->UseRealTime();
+BENCHMARK(BM_ParseFileAsync)->Apply(shapes)->UseRealTime();
+BENCHMARK(BM_ParseFileThreaded)->Apply(shapes)->UseRealTime();
+BENCHMARK(BM_WriteCsv)->Apply(shapes);
+BENCHMARK(BM_WriteCsvThreaded)->Apply(shapes)->UseRealTime();
+
+} // end namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,183 @@
+// File:   RinexGenerator.cpp
+// Description:
+// Deterministic synthetic RINEX 2.11 / 3.04 observation files for benchmarks.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "RinexGenerator.hpp"
+#include "../include/GnssTime.hpp"
+
+namespace rinex {
+namespace bench {
+
+// observation codes handed out in order, per RINEX version
+static const char* const kV3Codes[] = {"C1C", "L1C", "D1C", "S1C", "C2W", "L2W", "D2W", "S2W",
+                                       "C5Q", "L5Q", "D5Q", "S5Q", "C1W", "L1W", "C2L", "L2L",
+                                       "D2L", "S2L", "C7Q", "L7Q", "D7Q", "S7Q", "C6C", "L6C"};
+static const char* const kV2Codes[] = {"C1", "L1", "D1", "S1", "P2", "L2", "D2", "S2",
+                                       "C5", "L5", "D5", "S5", "P1", "C2", "C7", "L7",
+                                       "D7", "S7", "C6", "L6", "D6", "S6", "C8", "L8"};
+static constexpr int kNumCodes = sizeof(kV3Codes) / sizeof(kV3Codes[0]);
+// day of the first epoch, in days since 1970-01-01
+static constexpr int64_t kStartDay = days_from_civil(2024, 1, 15);
+
+// xorshift32; std distributions are not reproducible across standard libraries
+struct Rng {
+  uint32_t s;
+  uint32_t next() {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+  }
+  double uniform() { return next() * (1.0 / 4294967296.0); }
+};
+
+// append a header record: data padded to column 60, then the label
+static void header_line(std::string& out, const std::string& data, const char* label) {
+  std::string line = data;
+  line.resize(60, ' ');
+  out += line;
+  out += label;
+  out += '\n';
+}
+
+static void append_rtrim(std::string& out, std::string& line) {
+  size_t end = line.find_last_not_of(' ');
+  line.resize(end == std::string::npos ? 0 : end + 1);
+  out += line;
+  out += '\n';
+}
+
+std::string generate_rinex(const GeneratorOptions& opts) {
+  const bool v3 = opts.version >= 3;
+  const int ntypes = std::max(1, std::min(opts.num_obs_types, kNumCodes));
+  const std::string systems = opts.systems.empty() ? std::string("G") : opts.systems;
+  Rng rng{opts.seed ? opts.seed : 1};
+  char buf[128];
+  std::string out;
+
+  // header
+  snprintf(buf, sizeof(buf), "     %-15s%-20s%c", v3 ? "3.04" : "2.11", "OBSERVATION DATA",
+           systems.size() > 1 ? 'M' : systems[0]);
+  header_line(out, buf, "RINEX VERSION / TYPE");
+  header_line(out, "ReadRinex bench generator", "PGM / RUN BY / DATE");
+  header_line(out, "SYNT", "MARKER NAME");
+  if (v3) {
+    // each further system starts a signal later, so the tables overlap but differ
+    for (size_t k = 0; k < systems.size(); ++k) {
+      std::string line;
+      snprintf(buf, sizeof(buf), "%c  %3d", systems[k], ntypes);
+      line = buf;
+      for (int j = 0; j < ntypes; ++j) {
+        if (j > 0 && j % 13 == 0) {
+          header_line(out, line, "SYS / # / OBS TYPES");
+          line = "      ";
+        }
+        line += ' ';
+        line += kV3Codes[(j + 4 * k) % kNumCodes];
+      }
+      header_line(out, line, "SYS / # / OBS TYPES");
+    }
+  } else {
+    snprintf(buf, sizeof(buf), "%6d", ntypes);
+    std::string line = buf;
+    for (int j = 0; j < ntypes; ++j) {
+      if (j > 0 && j % 9 == 0) {
+        header_line(out, line, "# / TYPES OF OBSERV");
+        line = "      ";
+      }
+      snprintf(buf, sizeof(buf), "    %s", kV2Codes[j]);
+      line += buf;
+    }
+    header_line(out, line, "# / TYPES OF OBSERV");
+  }
+  snprintf(buf, sizeof(buf), "%10.3f", opts.interval);
+  header_line(out, buf, "INTERVAL");
+  header_line(out, "", "END OF HEADER");
+
+  // satellites and the smooth base range of each one
+  int nsat = std::max(1, std::min(opts.num_sats, 99));
+  std::vector<std::string> sats;
+  std::vector<double> base(nsat), rate(nsat);
+  for (int i = 0; i < nsat; ++i) {
+    char sys = systems[i % systems.size()];
+    snprintf(buf, sizeof(buf), "%c%02d", sys, i / (int)systems.size() + 1);
+    sats.push_back(buf);
+    base[i] = 2.0e7 + 6.0e6 * rng.uniform();
+    rate[i] = -800.0 + 1600.0 * rng.uniform();
+  }
+
+  // body
+  long nepochs = opts.interval > 0 ? (long)(opts.duration / opts.interval) : 1;
+  std::string line;
+  for (long e = 0; e < nepochs; ++e) {
+    double t = e * opts.interval;
+    int day = (int)(t / 86400.0);
+    double tod = t - day * 86400.0;
+    // the file starts on 2024-01-15; later days roll over into the following months
+    int year, month, mday;
+    civil_from_days(kStartDay + day, year, month, mday);
+    int hour = (int)(tod / 3600.0);
+    int minute = (int)((tod - hour * 3600.0) / 60.0);
+    double second = tod - hour * 3600.0 - minute * 60.0;
+    if (v3) {
+      snprintf(buf, sizeof(buf), "> %4d %02d %02d %02d %02d%11.7f  0%3d", year, month, mday, hour,
+               minute, second, nsat);
+      out += buf;
+      out += '\n';
+    } else {
+      snprintf(buf, sizeof(buf), " %02d %2d %2d %2d %2d%11.7f  0%3d", year % 100, month, mday, hour,
+               minute, second, nsat);
+      line = buf;
+      for (int i = 0; i < nsat; ++i) {
+        if (i > 0 && i % 12 == 0) {
+          append_rtrim(out, line);
+          line.assign(32, ' ');
+        }
+        line += sats[i];
+      }
+      append_rtrim(out, line);
+    }
+
+    for (int i = 0; i < nsat; ++i) {
+      double range = base[i] + rate[i] * t;
+      line = v3 ? sats[i] : std::string();
+      for (int j = 0; j < ntypes; ++j) {
+        if (!v3 && j > 0 && j % 5 == 0) {
+          append_rtrim(out, line);
+          line.clear();
+        }
+        double v;
+        switch (j % 4) {
+          case 0: v = range + rng.uniform(); break;            // code
+          case 1: v = range / 0.19029367 + rng.uniform(); break; // phase in cycles
+          case 2: v = -rate[i] / 0.19029367; break;            // Doppler
+          default: v = 35.0 + 15.0 * rng.uniform(); break;     // signal strength
+        }
+        int lli = (rng.next() % 97 == 0) ? 1 : 0;
+        int ssi = 5 + (int)(rng.next() % 5);
+        snprintf(buf, sizeof(buf), "%14.3f%c%d", v, lli ? '1' : ' ', ssi);
+        line += buf;
+      }
+      append_rtrim(out, line);
+    }
+  }
+  return out;
+}
+
+bool write_rinex(const std::string& path, const GeneratorOptions& opts) {
+  std::ofstream f(path, std::ios::binary);
+  if (!f) return false;
+  std::string text = generate_rinex(opts);
+  f.write(text.data(), (std::streamsize)text.size());
+  return (bool)f;
+}
+
+} // end namespace bench
+} // end namespace rinex
@@ -0,0 +1,29 @@
+// RinexGenerator.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace rinex {
+namespace bench {
+
+// Shape of a synthetic observation file. The output depends only on these options
+// (the generator has its own PRNG), so benchmark inputs are identical across runs
+// and platforms.
+struct GeneratorOptions {
+  int version = 3;              // 2 writes RINEX 2.11, 3 writes RINEX 3.04
+  double interval = 30.0;       // seconds between epochs
+  double duration = 86400.0;    // seconds covered by the file
+  int num_sats = 12;            // satellites per epoch
+  int num_obs_types = 8;        // observation types per satellite
+  std::string systems = "G";    // constellations, e.g., "GREC"; satellites are dealt round robin
+  uint32_t seed = 1;
+};
+
+// the whole file as text
+std::string generate_rinex(const GeneratorOptions& opts);
+
+// write generate_rinex(opts) to path; false on I/O error
+bool write_rinex(const std::string& path, const GeneratorOptions& opts);
+
+} // end namespace bench
+} // end namespace rinex
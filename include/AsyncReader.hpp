@@ -0,0 +1,83 @@
+// AsyncReader.hpp
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ByteSource.hpp"
+#include "SpscQueue.hpp"
+
+namespace rinex {
+
+// Reads many files at once with up to queue_depth large reads in flight, on one I/O
+// thread driving an io_uring (set up with the raw system calls; there is no liburing
+// dependency). Each opened file is read ahead into buffers_per_file buffers of
+// buffer_size bytes, at consecutive offsets, and its source hands the completed
+// buffers to the decoder in file order. Where io_uring is not available (old kernels,
+// seccomp filters, built without linux/io_uring.h) the same thread falls back to
+// pread, one read at a time, as it does for the rest of its life if the ring fails.
+//
+// Share one reader between the threads of a batch (ParseOptions::async_io), so a few
+// threads keep the device busy instead of each blocking on its own reads:
+//
+//   AsyncReader io;
+//   ParseOptions opts;
+//   opts.async_io = &io;
+//   parse_rinex_batch(paths, sink, opts);
+//
+// Files are read up to the size they had when opened. The reader must outlive the
+// sources it opened.
+class AsyncReader {
+public:
+  explicit AsyncReader(unsigned queue_depth = 64, size_t buffer_size = 1 << 20,
+                       size_t buffers_per_file = 4);
+  ~AsyncReader();
+
+  AsyncReader(const AsyncReader&) = delete;
+  AsyncReader& operator=(const AsyncReader&) = delete;
+
+  // stream path through the reader; nullptr if it cannot be opened. Thread safe.
+  std::unique_ptr<ByteSource> open(const std::string& path);
+
+  // "io_uring" or "pread"
+  const char* backend() const { return use_ring_.load(std::memory_order_acquire) ? "io_uring" : "pread"; }
+
+  struct Stream;
+  struct Ring;
+
+private:
+  friend class AsyncSource;
+
+  void run();
+  bool issue(Stream& s);
+  void read_now(Stream& s, uint32_t index);
+  void drop_ring();
+  bool complete(Stream& s, uint32_t index, int64_t result);
+  void deliver(Stream& s);
+  bool can_progress() const;
+
+  size_t buffer_size_;
+  size_t buffers_per_file_;
+  unsigned queue_depth_;
+  std::unique_ptr<Ring> ring_; // null with the pread fallback
+  std::atomic<bool> use_ring_{false};
+  std::vector<char*> retired_; // buffers a dropped ring may still write to, I/O thread only
+  unsigned in_flight_ = 0;     // reads submitted to the ring, I/O thread only
+  bool delivered_ = false;     // blocks queued in this round, I/O thread only
+
+  std::mutex open_mutex_;
+  std::vector<std::shared_ptr<Stream>> opened_; // new streams, under open_mutex_
+  std::vector<std::shared_ptr<Stream>> streams_; // I/O thread only
+  std::atomic<bool> have_opened_{false};
+  std::atomic<bool> stop_{false};
+  EventCount io_event_;     // buffers returned, files opened or closed
+  EventCount reader_event_; // buffers completed
+  std::thread thread_;
+};
+
+} // end namespace rinex
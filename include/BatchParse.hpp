@@ -0,0 +1,38 @@
+// BatchParse.hpp
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ParseRinex.hpp"
+
+namespace rinex {
+
+// outcome of one file of a batch
+struct BatchResult {
+  std::string path;
+  ParseRinexError error = ParseRinexError::Success;
+  RinexObs obs;
+};
+
+// Called once per file as soon as it is parsed, with its position in paths. Calls are
+// serialized, so the sink does not need to be thread safe; it may move obs away.
+using BatchSink = std::function<void(size_t index, const std::string& path, ParseRinexError error,
+                                     RinexObs& obs)>;
+
+// Parse many files on one work-stealing pool (opts.pool, or one of opts.threads
+// workers, where the default 1 as well as 0 start one per core; pass a pool of one
+// worker to parse on a single thread). Files are started largest first, and a file larger than
+// opts.min_chunk_bytes is split into chunk tasks on the same pool, so a few high-rate
+// files and many small daily files keep every worker busy. With opts.async_io each
+// file is instead streamed through that reader on one worker, the reads of all running
+// files sharing its queue. Results go to sink in completion order.
+void parse_rinex_batch(const std::vector<std::string>& paths, const BatchSink& sink,
+                       const ParseOptions& opts = ParseOptions());
+
+// same, collecting the results in the order of paths
+std::vector<BatchResult> parse_rinex_batch(const std::vector<std::string>& paths,
+                                           const ParseOptions& opts = ParseOptions());
+
+} // end namespace rinex
@@ -0,0 +1,121 @@
+// ByteSource.hpp
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.hpp"
+
+namespace rinex {
+
+class AsyncReader;
+
+// A forward-only stream of bytes. Decompressors are ByteSources wrapping another
+// ByteSource, so a .crx.gz file is read through FileSource -> GzipSource -> CrxSource.
+class ByteSource {
+public:
+  virtual ~ByteSource() = default;
+
+  // Copy up to n bytes into buf. Returns the number of bytes copied, 0 at the end of
+  // the stream or on error (see failed()).
+  virtual size_t read(char* buf, size_t n) = 0;
+
+  // true if the stream ended because of an I/O or format error
+  virtual bool failed() const { return false; }
+};
+
+// plain read(2) on a file descriptor
+class FileSource : public ByteSource {
+public:
+  explicit FileSource(const std::string& path);
+  ~FileSource() override;
+  bool is_open() const { return fd_ >= 0; }
+  size_t read(char* buf, size_t n) override;
+  bool failed() const override { return failed_; }
+
+private:
+  int fd_ = -1;
+  bool failed_ = false;
+};
+
+// Returns the bytes of prefix, then the rest of src. Used to put back the bytes that
+// were read to sniff the format of a stream.
+class PrefixedSource : public ByteSource {
+public:
+  PrefixedSource(std::string prefix, std::unique_ptr<ByteSource> src)
+      : prefix_(std::move(prefix)), src_(std::move(src)) {}
+  size_t read(char* buf, size_t n) override;
+  bool failed() const override { return src_->failed(); }
+
+private:
+  std::string prefix_;
+  size_t pos_ = 0;
+  std::unique_ptr<ByteSource> src_;
+};
+
+// Runs src on an I/O thread that reads ahead into num_buffers page aligned buffers of
+// buffer_size bytes, filling each one before handing it over. Full buffers travel to
+// the reader and drained ones back through two lock-free SPSC queues, so reading (or
+// decompressing) the next buffers overlaps with the decoding of the text and neither
+// thread takes a lock unless it has to wait for the other. A line cut at a buffer
+// edge is carried over by LineScanner, which keeps the unfinished line.
+class ThreadedSource : public ByteSource {
+public:
+  explicit ThreadedSource(std::unique_ptr<ByteSource> src, size_t buffer_size = 1 << 20,
+                          size_t num_buffers = 3);
+  ~ThreadedSource() override;
+  size_t read(char* buf, size_t n) override;
+  bool failed() const override { return failed_.load(std::memory_order_acquire); }
+
+private:
+  struct Block {
+    uint32_t index; // into buffers_
+    size_t size;
+  };
+  struct FreeBuffer {
+    void operator()(char* p) const { std::free(p); }
+  };
+
+  void run();
+
+  std::unique_ptr<ByteSource> src_;
+  size_t buffer_size_;
+  std::vector<std::unique_ptr<char, FreeBuffer>> buffers_;
+  SpscQueue<Block> full_;     // I/O thread -> reader
+  SpscQueue<uint32_t> empty_; // reader -> I/O thread
+  Block current_ = {0, 0};    // the buffer being read, if have_current_
+  bool have_current_ = false;
+  size_t current_pos_ = 0;
+  std::atomic<bool> done_{false}; // no more blocks will be queued
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> failed_{false};
+  EventCount event_;
+  std::thread thread_;
+};
+
+// How the bytes of an input file are encoded
+enum class InputFormat {
+  Plain,     // RINEX text
+  Gzip,      // gzip / zlib (.gz)
+  Compress,  // Unix compress LZW (.Z)
+  Hatanaka   // Compact RINEX text (.crx, .yyd)
+};
+
+// detect the encoding from the first bytes of a file
+InputFormat detect_input_format(std::string_view head);
+
+// Open path as a stream of plain RINEX text, stacking the decompressors that its
+// format needs. With threaded set, reading and decompression run on an I/O thread.
+// With io, the file is read through that reader, which reads ahead by itself, so only
+// decompression gets a thread of its own.
+// Returns nullptr if the file cannot be opened or its format is not supported.
+std::unique_ptr<ByteSource> open_rinex_text_source(const std::string& path, bool threaded = true,
+                                                   AsyncReader* io = nullptr);
+
+} // end namespace rinex
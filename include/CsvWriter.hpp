@@ -0,0 +1,55 @@
+// CsvWriter.hpp
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ParseRinex.hpp"
+#include "SatId.hpp"
+
+namespace rinex {
+
+class ThreadPool;
+
+// options for write_obs_csv
+struct CsvOptions {
+  // observation codes to write, in this order; empty writes all obs_types. Codes the
+  // file does not have are left out.
+  std::vector<std::string> obs_codes;
+
+  // satellites to write; empty writes all
+  std::vector<SatId> sats;
+
+  // follow each value by its LLI and SSI digits, as columns <code>_lli and <code>_ssi
+  bool flags = false;
+
+  char delimiter = ',';
+
+  // Threads formatting the rows; 0 uses one per core. Blocks of about block_bytes of
+  // text are formatted in parallel and written in order by the calling thread.
+  unsigned threads = 1;
+  size_t block_bytes = 1 << 20;
+
+  // format on this pool instead of a pool of its own
+  ThreadPool* pool = nullptr;
+};
+
+// Write obs as CSV, one line per satellite and epoch:
+//
+//   time,sat,C1C,L1C,...
+//   2024-01-01 00:00:00.0000000,G05,23456789.123,123456789.012,...
+//
+// Times are GPS calendar times in the time scale of the file, with the 7 decimals of
+// RINEX (9 where the time is finer). Values are written with 3 decimals like F14.3
+// fields, from integer thousandths, so both storages give the same text; 0, which is
+// how a missing observation is stored, is written as an empty field. Numbers are
+// formatted with std::to_chars into large buffers that are reused from block to block.
+// False on I/O error.
+bool write_obs_csv(std::ostream& out, const RinexObs& obs, const CsvOptions& opts = CsvOptions());
+
+// same, to path (through a temporary file that is renamed into place)
+bool write_obs_csv(const std::string& path, const RinexObs& obs,
+                   const CsvOptions& opts = CsvOptions());
+
+} // end namespace rinex
@@ -0,0 +1,117 @@
+// Decompress.hpp
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ByteSource.hpp"
+#include "MappedFile.hpp"
+#include "SatId.hpp"
+
+namespace rinex {
+
+// gzip (or zlib) inflate, including multi-member files. Only available when built
+// with zlib (RINEX_HAVE_ZLIB); otherwise every read fails.
+class GzipSource : public ByteSource {
+public:
+  explicit GzipSource(std::unique_ptr<ByteSource> src);
+  ~GzipSource() override;
+  size_t read(char* buf, size_t n) override;
+  bool failed() const override { return failed_; }
+
+private:
+  std::unique_ptr<ByteSource> src_;
+  std::vector<char> in_;
+  void* zs_ = nullptr; // z_stream, kept opaque so that zlib.h stays out of this header
+  bool eof_ = false;
+  bool failed_ = false;
+};
+
+// Unix compress (.Z): LZW with 9 to 16 bit codes
+class LzwSource : public ByteSource {
+public:
+  explicit LzwSource(std::unique_ptr<ByteSource> src) : src_(std::move(src)) {}
+  size_t read(char* buf, size_t n) override;
+  bool failed() const override { return failed_; }
+
+private:
+  bool read_header();
+  bool fill_input(size_t need_bits);
+  bool decode_some();
+
+  std::unique_ptr<ByteSource> src_;
+  std::vector<unsigned char> in_;
+  uint64_t in_base_bits_ = 0; // absolute bit position of in_[0]
+  uint64_t bitpos_ = 0;       // absolute bit position of the next code
+  uint64_t group_bits_ = 0;   // where codes of the current width started
+  bool in_eof_ = false;
+  bool started_ = false;
+  bool done_ = false;
+  bool failed_ = false;
+
+  int maxbits_ = 16;
+  bool block_mode_ = true;
+  int n_bits_ = 9;
+  uint32_t maxcode_ = 0;
+  uint32_t free_ent_ = 0;
+  int32_t oldcode_ = -1;
+  uint8_t finchar_ = 0;
+  std::vector<uint16_t> prefix_;
+  std::vector<uint8_t> suffix_;
+  std::vector<uint8_t> stack_;
+
+  std::vector<char> out_;
+  size_t out_pos_ = 0;
+};
+
+// Compact RINEX (Hatanaka) 1.0 / 3.0 to RINEX 2 / 3 text. Observations are rebuilt
+// from their arc-wise integer differences and LLI/SSI flags from their text
+// differences, one epoch at a time.
+class CrxSource : public ByteSource {
+public:
+  explicit CrxSource(std::unique_ptr<ByteSource> src);
+  size_t read(char* buf, size_t n) override;
+  bool failed() const override { return failed_; }
+
+private:
+  // reconstruction state of one observable of one satellite
+  struct Arc {
+    int order = -1; // differences held so far; -1 if there is no arc
+    int arc_order = 0;
+    int64_t u[10] = {};
+  };
+
+  bool next_line(std::string_view& line);
+  bool copy_header();
+  bool decode_epoch();
+  bool decode_diff(std::string_view field, Arc& arc, int64_t& value);
+  size_t num_types(SatId sv) const;
+  void emit(std::string_view s) { out_.append(s.data(), s.size()); }
+  void emit_line(std::string& s);
+
+  std::unique_ptr<ByteSource> src_;
+  LineScanner scanner_;
+  std::string out_;
+  size_t out_pos_ = 0;
+  bool in_header_ = true;
+  bool done_ = false;
+  bool failed_ = false;
+
+  bool is_v3_ = false;
+  size_t v2_types_ = 0;
+  size_t sys_types_[kNumSystems] = {};
+  std::string epoch_;        // last reconstructed epoch record
+  Arc clock_;
+  std::vector<std::vector<Arc>> arcs_; // per SatId::index(), one Arc per type
+  std::vector<std::string> flags_; // last LLI/SSI string per SatId::index()
+  std::vector<uint16_t> prev_sats_;  // SatId::index() of the previous epoch's satellites
+  std::vector<uint16_t> cur_sats_;
+  std::vector<uint8_t> in_prev_;     // per SatId::index(), 1 if in prev_sats_
+  std::string line_;
+  std::string values_;
+  static constexpr size_t kMaxTypes = 64;
+};
+
+} // end namespace rinex
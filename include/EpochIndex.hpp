@@ -0,0 +1,64 @@
+// EpochIndex.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ParseRinex.hpp"
+
+namespace rinex {
+
+// one epoch record of an indexed file
+struct EpochIndexEntry {
+  uint64_t offset; // byte offset of the epoch record in the file
+  int64_t time;    // GPS time of the epoch, ns (see gps_time_ns)
+};
+
+// Byte offset and time of every observation epoch of a plain RINEX file, so that a
+// time window can be decoded without reading what comes before it. An index is built
+// with one pass over the lines (observations are not converted) and can be kept next
+// to its file as a small sidecar:
+//
+//   EpochIndex index;
+//   index.open(path, path + ".idx");  // load the sidecar, or build and save it
+//   read_rinex_range(path, index, t0, t1, obs);
+//
+class EpochIndex {
+public:
+  // scan path; UnsupportedFormat for compressed or Compact RINEX input
+  ParseRinexError build(const std::string& path);
+
+  // write / read the sidecar file; load returns InvalidCache for a damaged file
+  bool save(const std::string& index_path) const;
+  ParseRinexError load(const std::string& index_path);
+
+  // load index_path if it was made from the current version of path, otherwise
+  // build the index and save it (an index that cannot be saved is not an error)
+  ParseRinexError open(const std::string& path, const std::string& index_path);
+
+  size_t size() const { return entries_.size(); }
+  const EpochIndexEntry& operator[](size_t i) const { return entries_[i]; }
+  const std::vector<EpochIndexEntry>& entries() const { return entries_; }
+
+  // size and modification time (ns) of the indexed file
+  uint64_t source_size() const { return source_size_; }
+  int64_t source_mtime() const { return source_mtime_; }
+
+  // Entries [first, last) with t0 <= time < t1, by binary search. Epoch times are
+  // expected to increase through the file.
+  std::pair<size_t, size_t> range(int64_t t0, int64_t t1) const;
+
+private:
+  std::vector<EpochIndexEntry> entries_;
+  uint64_t source_size_ = 0;
+  int64_t source_mtime_ = 0;
+};
+
+// Decode the epochs of path with t0 <= time < t1 into out, starting straight at the
+// first of them. Returns InvalidCache if index does not match the file.
+ParseRinexError read_rinex_range(const std::string& path, const EpochIndex& index, int64_t t0,
+                                 int64_t t1, RinexObs& out, const ParseOptions& opts = ParseOptions());
+
+} // end namespace rinex
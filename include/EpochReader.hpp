@@ -0,0 +1,87 @@
+// EpochReader.hpp
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ByteSource.hpp"
+#include "MappedFile.hpp"
+#include "ParseRinex.hpp"
+#include "ParseStats.hpp"
+
+namespace rinex {
+
+// Pull-style streaming reader. open() parses the header; each call to next() decodes
+// one complete epoch into a caller supplied buffer, so memory use does not depend on
+// the length of the file:
+//
+//   EpochReader reader;
+//   if (reader.open(path) != ParseRinexError::Success) ...
+//   ObsEpoch ep;
+//   while (reader.next(ep)) process(ep);
+//
+class EpochReader {
+public:
+  // Map path and parse its header. gzip, Unix compress and Compact RINEX (Hatanaka)
+  // files are detected by their first bytes and decoded on a separate thread while
+  // the text is parsed, without temporary files. With io_thread, files are read on
+  // that thread and never mapped, their format sniffed from the stream (see
+  // ParseOptions::io_thread), and with io they are read through that reader
+  // (ParseOptions::async_io).
+  ParseRinexError open(const std::string& path, bool io_thread = false, AsyncReader* io = nullptr);
+
+  // decode the observation records in body (which must outlive the reader) with an
+  // already parsed header, e.g. one chunk of a file split by find_epoch_start
+  void open(std::string_view body, const RinexHeader& hdr);
+
+  const RinexHeader& header() const { return header_; }
+
+  // Count lines, records and stage times into stats from now on (nullptr stops). Set it
+  // before open() to include the header.
+  void set_stats(ParseStats* stats) { stats_ = stats; }
+
+  // decode only the given observation codes from now on (see rinex::select_obs_types)
+  ParseRinexError select_obs_types(const std::vector<std::string>& codes);
+
+  // decode into ObsEpoch::obs_fixed instead of obs from now on (see ParseOptions::fixed_point)
+  void set_fixed_point(bool on) { header_.fixed_point = on; }
+
+  // Decode the next complete epoch into ep, reusing its storage. Epochs cut short by
+  // the end of the file or by the next epoch record are dropped. False at end of file.
+  bool next(ObsEpoch& ep);
+
+  // input offset of the next line to be read; after next() returned true, the end of
+  // the epoch it decoded
+  size_t offset() const { return scanner_.offset(); }
+
+private:
+  // the decoders are compiled with and without the ParseStats counting
+  template <bool kStats> bool next_v3(ObsEpoch& ep);
+  template <bool kStats> bool next_v2(ObsEpoch& ep);
+  template <bool kStats> bool next_line(std::string_view& line);
+  template <bool kStats> void unread_line(size_t mark);
+  template <bool kStats> void skip_event(const ObsEpoch& ep);
+  template <bool kStats> void count_sat(GnssSystem sys);
+  size_t v2_lines_per_sat() const;
+
+  MappedFile file_;
+  std::unique_ptr<ByteSource> source_; // decompression chain for encoded input
+  LineScanner scanner_;
+  RinexHeader header_;
+  std::vector<SatId> sv_ids_; // RINEX 2 satellite list of the current epoch
+  ParseStats* stats_ = nullptr;
+};
+
+// Offset of the first epoch record that starts on a line at or after pos in body
+// (the observation records following END OF HEADER), or body.size() if there is none.
+// Used to cut a body into chunks that can be decoded independently.
+size_t find_epoch_start(std::string_view body, size_t pos, bool is_v3);
+
+// Push-style wrapper around EpochReader: fn is called with every epoch as soon as it
+// is complete and returns false to stop early. The header is stored in hdr first.
+ParseRinexError for_each_epoch(const std::string& path, RinexHeader& hdr,
+                               const std::function<bool(const ObsEpoch&)>& fn);
+
+} // end namespace rinex
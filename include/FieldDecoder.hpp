@@ -0,0 +1,164 @@
+// FieldDecoder.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "ObsFlags.hpp"
+#include "ParseRinex.hpp"
+
+namespace rinex {
+
+// RINEX records are fixed-column (Fortran In / Fw.d edit descriptors). The decoders
+// below read a field straight from its column range in a line view. Columns past the
+// end of a right-trimmed line count as blank. Nothing allocates and the locale is
+// never consulted.
+
+// one observation slot: F14.3 value followed by the LLI and SSI digits
+constexpr size_t kObsSlotWidth = 16;
+constexpr size_t kObsValueWidth = 14;
+
+// first observation column of a RINEX 3 satellite line (after the A3 satellite id)
+constexpr size_t kV3FirstObsCol = 3;
+
+// RINEX 2 epoch records list up to 12 satellites (A3 each) starting at column 32
+constexpr size_t kV2SatListCol = 32;
+constexpr size_t kV2SatsPerLine = 12;
+
+// RINEX 2 observation records wrap after five slots onto continuation lines
+constexpr size_t kV2ObsPerLine = 5;
+
+// powers of ten that are exactly representable as doubles
+constexpr double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                             1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+
+// Integer field (In) at [col, col+width). Leading blanks and a sign are allowed.
+// Returns false if the field is blank or holds anything but an integer.
+inline bool decode_int_field(std::string_view line, size_t col, size_t width, int& v) {
+  if (col >= line.size()) return false;
+  std::string_view f = line.substr(col, width);
+  size_t i = 0, n = f.size();
+  while (i < n && f[i] == ' ') ++i;
+  if (i == n) return false;
+  bool neg = false;
+  if (f[i] == '-' || f[i] == '+') { neg = f[i] == '-'; ++i; }
+  int x = 0, digits = 0;
+  for (; i < n && f[i] >= '0' && f[i] <= '9'; ++i, ++digits) x = x * 10 + (f[i] - '0');
+  if (digits == 0 || digits > 9) return false;
+  for (; i < n; ++i) if (f[i] != ' ') return false; // only blanks may follow
+  v = neg ? -x : x;
+  return true;
+}
+
+// Fixed point field (Fw.d) at [col, col+width). The digits are accumulated as an
+// integer and scaled once by a power of ten, so for up to 15 significant digits the
+// result is the correctly rounded double, identical to strtod.
+// Returns false if the field is blank or malformed.
+inline bool decode_fixed_field(std::string_view line, size_t col, size_t width, double& v) {
+  if (col >= line.size()) return false;
+  std::string_view f = line.substr(col, width);
+  size_t i = 0, n = f.size();
+  while (i < n && f[i] == ' ') ++i;
+  if (i == n) return false;
+  bool neg = false;
+  if (f[i] == '-' || f[i] == '+') { neg = f[i] == '-'; ++i; }
+  int64_t m = 0;
+  int digits = 0, frac = -1;
+  for (; i < n; ++i) {
+    char c = f[i];
+    if (c >= '0' && c <= '9') {
+      m = m * 10 + (c - '0');
+      ++digits;
+      if (frac >= 0) ++frac;
+    } else if (c == '.' && frac < 0) {
+      frac = 0;
+    } else {
+      break;
+    }
+  }
+  if (digits == 0) return false;
+  for (; i < n; ++i) if (f[i] != ' ') return false; // only blanks may follow
+  double d = (double)m;
+  if (frac > 0) d /= kPow10[frac];
+  v = neg ? -d : d;
+  return true;
+}
+
+// Seconds field (Fw.d, at most 9 decimals used) at [col, col+width) as an exact count of
+// nanoseconds. Returns false if the field is blank, negative or malformed, or has more
+// than 3 whole digits (RINEX writes F11.7 seconds, and more would overflow).
+inline bool decode_seconds_ns(std::string_view line, size_t col, size_t width, int64_t& ns) {
+  if (col >= line.size()) return false;
+  std::string_view f = line.substr(col, width);
+  size_t i = 0, n = f.size();
+  while (i < n && f[i] == ' ') ++i;
+  int64_t whole = 0, frac = 0;
+  int digits = 0, frac_digits = -1;
+  for (; i < n; ++i) {
+    char c = f[i];
+    if (c >= '0' && c <= '9') {
+      ++digits;
+      if (frac_digits < 0) {
+        if (digits > 3) return false;
+        whole = whole * 10 + (c - '0');
+      } else if (frac_digits < 9) {
+        frac = frac * 10 + (c - '0');
+        ++frac_digits;
+      }
+    } else if (c == '.' && frac_digits < 0) {
+      frac_digits = 0;
+    } else {
+      break;
+    }
+  }
+  if (digits == 0) return false;
+  for (; i < n; ++i) if (f[i] != ' ') return false; // only blanks may follow
+  for (int k = frac_digits < 0 ? 0 : frac_digits; k < 9; ++k) frac *= 10;
+  ns = whole * 1000000000 + frac;
+  return true;
+}
+
+// F14.3 observation value of the slot starting at col; false if the slot is blank
+inline bool decode_obs_value(std::string_view line, size_t col, double& v) {
+  return decode_fixed_field(line, col, kObsValueWidth, v);
+}
+
+// LLI and SSI digits of the slot starting at col, packed (see pack_obs_flags). Blanks
+// and anything but a digit read as 0, so the digits never leak into the next value.
+inline uint8_t decode_obs_flags(std::string_view line, size_t col) {
+  auto digit = [&](size_t c) {
+    return c < line.size() && line[c] >= '0' && line[c] <= '9' ? line[c] - '0' : 0;
+  };
+  return pack_obs_flags(digit(col + kObsValueWidth), digit(col + kObsValueWidth + 1));
+}
+
+// Batch decoding of the observation slots of one record line: slot s starts at column
+// first_col + (s.slot - slot_base) * kObsSlotWidth and is decoded into values[s.column]
+// and flags[s.column]. Blank values are left untouched; the flags are always written.
+//
+// Values written the way RINEX writers do (F14.3: right-aligned, optional '-', decimal
+// point in column 10 of the field) are decoded several slots at a time with SSE2/AVX2:
+// digits, blanks and sign are classified bytewise and the mantissa is accumulated in
+// 16-bit lanes. Any other spelling goes through decode_fixed_field. The results are
+// the same as decode_obs_value/decode_obs_flags slot by slot.
+void decode_obs_slots(std::string_view line, size_t first_col, size_t slot_base,
+                      const ObsSlot* slots, size_t n, double* values, uint8_t* flags);
+
+// As above, with the values as integers in units of 0.001 (exact for F14.3 fields;
+// other spellings are rounded to the nearest thousandth)
+void decode_obs_slots(std::string_view line, size_t first_col, size_t slot_base,
+                      const ObsSlot* slots, size_t n, int64_t* values, uint8_t* flags);
+
+// "avx2", "sse2" or "scalar": the kernel decode_obs_slots runs
+const char* obs_decode_kernel();
+
+// Decode a RINEX 3 epoch record "> yyyy mm dd hh mm ss.sssssss  e nnn" into the
+// time, event flag and satellite count of ep. Returns false if the record is malformed.
+bool decode_epoch_v3(std::string_view line, ObsEpoch& ep);
+
+// Decode a RINEX 2 epoch record " yy mm dd hh mm ss.sssssss  e nnn" (the satellite
+// list that follows is left to the caller). Two digit years are expanded to 1980-2079.
+// Returns false if the line is not an epoch record.
+bool decode_epoch_v2(std::string_view line, ObsEpoch& ep);
+
+} // end namespace rinex
@@ -0,0 +1,90 @@
+// GnssTime.hpp
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace rinex {
+
+constexpr int64_t kNsPerSecond = 1000000000;
+constexpr int64_t kNsPerDay = 86400 * kNsPerSecond;
+constexpr int64_t kNsPerWeek = 7 * kNsPerDay;
+
+// Calendar form of a time. The parser keeps times as one int64 count of nanoseconds
+// since the GPS epoch and derives these fields only on request.
+struct CalendarTime {
+  int year = 0;
+  int month = 0;
+  int day = 0;
+  int hour = 0;
+  int minute = 0;
+  double second = 0.0;
+};
+
+// days from 1970-01-01 to year-month-day of the proleptic Gregorian calendar
+constexpr int64_t days_from_civil(int year, int month, int day) {
+  int64_t y = (int64_t)year - (month <= 2 ? 1 : 0);
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// inverse of days_from_civil
+constexpr void civil_from_days(int64_t z, int& year, int& month, int& day) {
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  day = (int)(doy - (153 * mp + 2) / 5 + 1);
+  month = (int)(mp < 10 ? mp + 3 : mp - 9);
+  year = (int)(yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+// floor(a / b) for b > 0
+constexpr int64_t floor_div(int64_t a, int64_t b) {
+  return a / b - ((a % b != 0 && a < 0) ? 1 : 0);
+}
+
+// start of GPS time, 1980-01-06 00:00:00
+constexpr int64_t kGpsEpochDays = days_from_civil(1980, 1, 6);
+
+// nanoseconds since the GPS epoch of a date and time of day given in nanoseconds
+constexpr int64_t gps_time_from_day(int year, int month, int day, int64_t ns_of_day) {
+  return (days_from_civil(year, month, day) - kGpsEpochDays) * kNsPerDay + ns_of_day;
+}
+
+// Nanoseconds since the GPS epoch of a calendar time that is already in the GPS time
+// scale (as RINEX epochs of GPS receivers are), so no leap seconds are applied.
+// Seconds are rounded to the nearest nanosecond.
+inline int64_t gps_time_ns(int year, int month, int day, int hour, int minute, double second) {
+  int64_t ns = ((int64_t)hour * 3600 + minute * 60) * kNsPerSecond + (int64_t)std::llround(second * 1e9);
+  return gps_time_from_day(year, month, day, ns);
+}
+
+inline CalendarTime calendar_from_gps_ns(int64_t ns) {
+  CalendarTime c;
+  int64_t days = floor_div(ns, kNsPerDay);
+  int64_t rem = ns - days * kNsPerDay;
+  civil_from_days(days + kGpsEpochDays, c.year, c.month, c.day);
+  c.hour = (int)(rem / (3600 * kNsPerSecond));
+  rem -= c.hour * 3600 * kNsPerSecond;
+  c.minute = (int)(rem / (60 * kNsPerSecond));
+  rem -= c.minute * 60 * kNsPerSecond;
+  c.second = (double)rem / 1e9;
+  return c;
+}
+
+// GPS week number and seconds of week
+inline int gps_week(int64_t ns) { return (int)floor_div(ns, kNsPerWeek); }
+inline double gps_seconds_of_week(int64_t ns) {
+  return (double)(ns - floor_div(ns, kNsPerWeek) * kNsPerWeek) / 1e9;
+}
+
+static_assert(days_from_civil(1970, 1, 1) == 0, "civil day zero");
+static_assert(kGpsEpochDays == 3657, "GPS epoch");
+static_assert(days_from_civil(2024, 2, 29) - days_from_civil(2024, 1, 1) == 59, "leap day");
+
+} // end namespace rinex
@@ -0,0 +1,69 @@
+// LineScan.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace rinex {
+
+// Vectorized byte scanning for the line splitter and the header reader. On x86-64
+// the scans use AVX2 when the CPU has it and SSE2 otherwise; elsewhere, or when built
+// with RINEX_NO_SIMD, a scalar loop. The choice is made once, on first use.
+
+// first '\n' in [p, end), or end if there is none
+const char* find_newline(const char* p, const char* end);
+
+// name of the scan kernel in use ("avx2", "sse2" or "scalar")
+const char* line_scan_kernel();
+
+// True if the vectorized kernels (here, in FieldDecoder and in ObsFlags) run their AVX2
+// versions: the CPU has AVX2 and RINEX_NO_AVX2 is not set in the environment, which
+// keeps them on SSE2, e.g. to compare the two. False without x86-64 SIMD.
+bool simd_use_avx2();
+
+// RINEX header records carry their label in columns 60-79
+constexpr size_t kHeaderLabelCol = 60;
+constexpr size_t kHeaderLabelWidth = 20;
+
+// the header labels of observation files (RINEX 2.11 and 3.0x)
+enum class HeaderLabel : uint8_t {
+  Unknown,
+  VersionType,      // RINEX VERSION / TYPE
+  ProgRunByDate,    // PGM / RUN BY / DATE
+  Comment,          // COMMENT
+  MarkerName,       // MARKER NAME
+  MarkerNumber,     // MARKER NUMBER
+  MarkerType,       // MARKER TYPE
+  ObserverAgency,   // OBSERVER / AGENCY
+  ReceiverType,     // REC # / TYPE / VERS
+  AntennaType,      // ANT # / TYPE
+  ApproxPosition,   // APPROX POSITION XYZ
+  AntennaDeltaHEN,  // ANTENNA: DELTA H/E/N
+  AntennaDeltaXYZ,  // ANTENNA: DELTA X/Y/Z
+  WavelengthFact,   // WAVELENGTH FACT L1/2
+  TypesOfObserv,    // # / TYPES OF OBSERV
+  SysObsTypes,      // SYS / # / OBS TYPES
+  SignalStrength,   // SIGNAL STRENGTH UNIT
+  Interval,         // INTERVAL
+  TimeOfFirstObs,   // TIME OF FIRST OBS
+  TimeOfLastObs,    // TIME OF LAST OBS
+  RcvClockOffsApl,  // RCV CLOCK OFFS APPL
+  SysDcbsApplied,   // SYS / DCBS APPLIED
+  SysPcvsApplied,   // SYS / PCVS APPLIED
+  SysScaleFactor,   // SYS / SCALE FACTOR
+  SysPhaseShift,    // SYS / PHASE SHIFT
+  GlonassSlotFrq,   // GLONASS SLOT / FRQ #
+  GlonassCodPhsBis, // GLONASS COD/PHS/BIS
+  LeapSeconds,      // LEAP SECONDS
+  NumSatellites,    // # OF SATELLITES
+  PrnNumObs,        // PRN / # OF OBS
+  EndOfHeader,      // END OF HEADER
+};
+
+// Label of a header record. The label slot is compared against a hash table of the
+// labels above, so a well-formed record costs one lookup whatever its label. Records
+// whose label is not in its slot (some writers misalign it) are searched for the
+// labels the parser depends on, as older versions of the reader did.
+HeaderLabel header_label(std::string_view line);
+
+} // end namespace rinex
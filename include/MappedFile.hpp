@@ -0,0 +1,96 @@
+// MappedFile.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineScan.hpp"
+
+namespace rinex {
+
+// Read-only view of a whole file. The file is memory mapped where possible so
+// that line views handed out by LineScanner point straight into the page cache;
+// if mapping fails (pipes, special files) the bytes are read into a private buffer.
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& path) { open(path); }
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  // returns false if the file cannot be opened or read
+  bool open(const std::string& path);
+  void close();
+
+  bool is_open() const { return open_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+  bool mapped_ = false;
+  std::vector<char> fallback_; // used when the file cannot be mapped
+};
+
+// size and modification time (ns since 1970) of path; false if it cannot be stat'ed.
+// Used to tell whether a cache or index file still matches its source.
+bool file_stamp(const std::string& path, uint64_t& size, int64_t& mtime);
+
+class ByteSource;
+
+// Walks a byte range line by line. Each line is returned as a view without the
+// trailing "\n" or "\r\n"; nothing is copied.
+//
+// In stream mode the bytes are pulled from a ByteSource into an internal buffer as
+// lines are consumed. A returned line then stays valid until the next call to next(),
+// and seek() can only go back as far as the start of the line last returned.
+class LineScanner {
+public:
+  LineScanner() = default;
+  explicit LineScanner(std::string_view buf) : buf_(buf) {}
+  explicit LineScanner(ByteSource* src) : src_(src) {}
+
+  bool next(std::string_view& line) {
+    size_t nl = std::string_view::npos;
+    if (pos_ < buf_.size()) {
+      const char* p = find_newline(buf_.data() + pos_, buf_.data() + buf_.size());
+      if (p != buf_.data() + buf_.size()) nl = (size_t)(p - buf_.data());
+    }
+    if (nl == std::string_view::npos && src_) nl = refill();
+    if (pos_ >= buf_.size()) return false;
+    size_t end = (nl == std::string_view::npos) ? buf_.size() : nl;
+    line = buf_.substr(pos_, end - pos_);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    pos_ = (nl == std::string_view::npos) ? buf_.size() : nl + 1;
+    return true;
+  }
+
+  // byte offset (from the start of the input) of the next line to be returned
+  size_t offset() const { return base_ + pos_; }
+  void seek(size_t pos) {
+    pos = pos > base_ ? pos - base_ : 0;
+    pos_ = pos < buf_.size() ? pos : buf_.size();
+  }
+
+private:
+  // stream mode: read until the buffer holds a complete line; returns the offset of
+  // its newline or npos at the end of the stream
+  size_t refill();
+
+  std::string_view buf_;
+  size_t pos_ = 0;
+  size_t base_ = 0; // input offset of buf_[0]
+  ByteSource* src_ = nullptr;
+  std::vector<char> storage_;
+};
+
+} // end namespace rinex
@@ -0,0 +1,86 @@
+// ObsCache.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.hpp"
+#include "ParseRinex.hpp"
+
+namespace rinex {
+
+// Binary columnar cache of a parsed observation file. The layout mirrors RinexObs: a
+// fixed header, the observation type tables, then one 8-byte aligned section per
+// array (epoch times, flags, epoch row offsets, satellite table, row satellites, one
+// column per observation type and one LLI/SSI column per type), all in native byte order. A cache is only meant
+// to be read back on the machine that wrote it. The columns of fixed-point observations
+// (ParseOptions::fixed_point) are stored as they are, int64 thousandths.
+//
+// ObsCache maps such a file and hands out pointers into the mapping, so opening one
+// costs a header check and a pass over the epoch and row tables, but never touches the
+// observation columns.
+class ObsCache {
+public:
+  // Map path and validate its header, its section bounds and the tables that index the
+  // columns (epoch row offsets, row satellites). InvalidCache if any of them is off.
+  ParseRinexError open(const std::string& path);
+  void close();
+
+  const RinexHeader& header() const { return header_; }
+  size_t num_epochs() const { return num_epochs_; }
+  size_t num_rows() const { return num_rows_; }
+  size_t num_sats() const { return num_sats_; }
+
+  const int64_t* epoch_time() const { return epoch_time_; }
+  const uint8_t* epoch_flag() const { return epoch_flag_; }
+  const uint32_t* epoch_begin() const { return epoch_begin_; }
+  const uint16_t* row_sat() const { return row_sat_; }
+  // column of a cache of double / fixed-point observations (header().fixed_point);
+  // nullptr from the accessor of the other storage
+  const double* column(size_t type) const { return columns_ ? columns_ + type * num_rows_ : nullptr; }
+  const int64_t* fixed_column(size_t type) const {
+    return fixed_columns_ ? fixed_columns_ + type * num_rows_ : nullptr;
+  }
+  const uint8_t* flags(size_t type) const { return flags_ + type * num_rows_; }
+  SatId sat(size_t i) const { return SatId((GnssSystem)(sats_[i] >> 8), sats_[i] & 0xff); }
+
+  // size and modification time (ns) of the RINEX file the cache was made from
+  uint64_t source_size() const { return source_size_; }
+  int64_t source_mtime() const { return source_mtime_; }
+
+  // copy everything into out, e.g. to append more epochs to it
+  void copy_to(RinexObs& out) const;
+
+private:
+  MappedFile file_;
+  RinexHeader header_;
+  size_t num_epochs_ = 0;
+  size_t num_rows_ = 0;
+  size_t num_sats_ = 0;
+  uint64_t source_size_ = 0;
+  int64_t source_mtime_ = 0;
+  const int64_t* epoch_time_ = nullptr;
+  const uint8_t* epoch_flag_ = nullptr;
+  const uint32_t* epoch_begin_ = nullptr;
+  const uint16_t* sats_ = nullptr;
+  const uint16_t* row_sat_ = nullptr;
+  const double* columns_ = nullptr;
+  const int64_t* fixed_columns_ = nullptr;
+  const uint8_t* flags_ = nullptr;
+};
+
+// Write obs to path (through a temporary file that is renamed into place). The size
+// and modification time of source_path, if given, are recorded so that
+// parse_rinex_obs_cached can tell whether the cache is stale. False on I/O error.
+bool write_obs_cache(const std::string& path, const RinexObs& obs,
+                     const std::string& source_path = std::string());
+
+// read a cache written by write_obs_cache into out
+ParseRinexError read_obs_cache(const std::string& path, RinexObs& out);
+
+// Load cache_path if it was made from the current version of path with the same
+// observation code selection and storage; otherwise parse path and (re)write cache_path.
+ParseRinexError parse_rinex_obs_cached(const std::string& path, const std::string& cache_path,
+                                       RinexObs& out, const ParseOptions& opts = ParseOptions());
+
+} // end namespace rinex
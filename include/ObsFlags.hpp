@@ -0,0 +1,34 @@
+// ObsFlags.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rinex {
+
+// Every observation value is followed in its record by a loss of lock indicator (LLI)
+// and a signal strength indicator (SSI), one digit each. They are kept packed in one
+// byte per value, LLI in the low and SSI in the high nibble; a blank digit reads as 0.
+constexpr uint8_t pack_obs_flags(int lli, int ssi) { return (uint8_t)((ssi << 4) | (lli & 0x0f)); }
+constexpr int obs_lli(uint8_t flags) { return flags & 0x0f; }
+constexpr int obs_ssi(uint8_t flags) { return flags >> 4; }
+
+// LLI bits, as flag masks
+constexpr uint8_t kLliLossOfLock = 0x01;   // lost lock since the previous epoch: possible cycle slip
+constexpr uint8_t kLliHalfCycle = 0x02;    // half-cycle ambiguity / slip possible
+constexpr uint8_t kLliAntiSpoofing = 0x04; // under anti-spoofing (RINEX 2) or BOC tracking (RINEX 3)
+constexpr uint8_t kLliSlipMask = kLliLossOfLock | kLliHalfCycle;
+
+// Scans over a flag column (RinexObs::flags[t]), vectorized with SSE2/AVX2 like the
+// line scanner, 64 flags per step.
+
+// first i in [from, n) with flags[i] & mask, or n if there is none
+size_t find_flagged(const uint8_t* flags, size_t n, uint8_t mask, size_t from = 0);
+
+// number of i in [0, n) with flags[i] & mask
+size_t count_flagged(const uint8_t* flags, size_t n, uint8_t mask);
+
+// every i in [0, n) with flags[i] & mask, in ascending order
+std::vector<uint32_t> flagged_rows(const uint8_t* flags, size_t n, uint8_t mask);
+
+} // end namespace rinex
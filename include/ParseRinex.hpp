@@ -1,33 +1,164 @@
 // ParseRinex.hpp
 #pragma once 
-#include <unordered_map>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "GnssTime.hpp"
+#include "MappedFile.hpp"
+#include "SatId.hpp"
+
 namespace rinex {
 
-// Represents a single observation epoch, storing L1/L2 measurements for each satellite.
-// The map key is the normalized satellite ID (e.g., "G01"), and the value is a pair
-// of doubles: (L1 measurement, L2 measurement).
+// In fixed-point storage (ParseOptions::fixed_point) observations are kept as int64
+// counts of 0.001, the resolution of the F14.3 record fields, so every value written
+// in a file is stored exactly and converts to the same double the float storage holds.
+constexpr double kFixedPointScale = 1e3;
+inline double from_fixed_point(int64_t v) { return (double)v / kFixedPointScale; }
+inline int64_t to_fixed_point(double v) { return std::llround(v * kFixedPointScale); }
+
+// Represents a single observation epoch. Satellites are kept in file order and their
+// observations row-major in obs: obs[i * num_obs + j] is observation type j of sats[i],
+// with j indexing the header's obs_types (0.0 where the satellite has no such value).
+// flags runs parallel to obs with the packed LLI/SSI digits of each value (ObsFlags.hpp).
+// In fixed-point storage the values are in obs_fixed, laid out the same, and obs is empty.
+// A reused ObsEpoch keeps its capacity, so refilling it does not allocate.
 struct ObsEpoch {
-  int year = 0;
-  int month = 0;
-  int day = 0;
-  int hour = 0;
-  int minute = 0;
-  double second = 0.0;
+  ObsEpoch() = default;
+  explicit ObsEpoch(std::pmr::memory_resource* mr) : sats(mr), obs(mr), obs_fixed(mr), flags(mr) {}
+
+  int64_t time = 0; // ns since the GPS epoch, in the time scale of the file
   int event_flag = 0;
   int num_sv = 0;
-  std::unordered_map<std::string, std::pair<double, double>> sat_L1L2;
+  size_t num_obs = 0; // observation values per satellite
+  bool fixed_point = false; // values are in obs_fixed
+  std::pmr::vector<SatId> sats;
+  std::pmr::vector<double> obs;
+  std::pmr::vector<int64_t> obs_fixed; // in units of 0.001
+  std::pmr::vector<uint8_t> flags;
+
+  CalendarTime calendar() const { return calendar_from_gps_ns(time); }
+  size_t size() const { return sats.size(); }
+  size_t num_values() const { return fixed_point ? obs_fixed.size() : obs.size(); }
+  const double* sat_obs(size_t i) const { return obs.data() + i * num_obs; }
+  const int64_t* sat_obs_fixed(size_t i) const { return obs_fixed.data() + i * num_obs; }
+  const uint8_t* sat_flags(size_t i) const { return flags.data() + i * num_obs; }
+
+  // observation j of sats[i], in either storage
+  double value(size_t i, size_t j) const {
+    return fixed_point ? from_fixed_point(obs_fixed[i * num_obs + j]) : obs[i * num_obs + j];
+  }
+  void clear_sats() { sats.clear(); obs.clear(); obs_fixed.clear(); flags.clear(); }
 };
 
-// organizes the RINEX observations, including RINEX version, the observations types,
-// and the collection of ObsEpochs.  
-struct RinexObs{
+// one observation slot to decode: its position in the record and its column in obs_types
+struct ObsSlot {
+    uint16_t slot;
+    uint16_t column;
+};
+
+// the header information needed to decode observation records
+struct RinexHeader {
     bool is_v3=false;
+    bool fixed_point=false; // decode into fixed-point storage (ParseOptions::fixed_point)
     std::vector<std::string> obs_types; // as in header, e.g., L1C, L1P, L2W, etc.
-    std::vector<ObsEpoch> epochs;
+
+    // Per-system observation type tables, indexed by GnssSystem. sys_obs_types[s] lists
+    // the types of system s in record order and sys_slots[s] the slots of its records
+    // that are decoded, with their columns. RINEX 3 obs_types is the union of all
+    // systems' types, in order of first appearance (or the selection made by
+    // select_obs_types). RINEX 2 has one table, shared by every system. Satellites of a
+    // system without slots are not stored.
+    std::vector<std::string> sys_obs_types[kNumSystems];
+    std::vector<ObsSlot> sys_slots[kNumSystems];
+
+    const std::vector<ObsSlot>& slots(GnssSystem sys) const { return sys_slots[(size_t)sys]; }
+
+    // position of code in obs_types, or -1
+    int obs_type_index(std::string_view code) const;
+};
+
+// organizes the RINEX observations, including RINEX version, the observations types,
+// and a columnar store of all epochs. Epoch e owns rows [rows_begin(e), rows_end(e));
+// each row is one satellite of that epoch (row_sat indexes the satellite table sats)
+// and obs[t][row] is observation type obs_types[t] of that row, so a scan over one
+// observable or one satellite arc touches contiguous memory. flags[t][row] holds the
+// packed LLI/SSI of obs[t][row], one byte each, for vectorized slip screening.
+// In fixed-point storage the columns are obs_fixed[t] instead and obs is empty; value()
+// reads either.
+//
+// The epoch arrays and columns allocate from a std::pmr memory resource. With an arena
+// the whole parse of a file comes out of a few large blocks, released at once when
+// the arena goes away (which must outlive the RinexObs):
+//
+//   std::pmr::monotonic_buffer_resource arena;
+//   RinexObs obs(&arena);
+//   parse_rinex_obs(path, obs);
+//
+struct RinexObs : RinexHeader {
+    RinexObs() = default;
+    explicit RinexObs(std::pmr::memory_resource* mr)
+        : epoch_time(mr), epoch_flag(mr), epoch_begin(mr), sats(mr), row_sat(mr), obs(mr),
+          obs_fixed(mr), flags(mr), sat_lookup_(mr) {}
+
+    std::pmr::vector<int64_t> epoch_time;     // ns since the GPS epoch, one entry per epoch
+    std::pmr::vector<uint8_t> epoch_flag;     // event flag per epoch
+    std::pmr::vector<uint32_t> epoch_begin;   // first row of each epoch
+    std::pmr::vector<SatId> sats;             // satellite index table
+    std::pmr::vector<uint16_t> row_sat;       // satellite index of each row
+    std::pmr::vector<std::pmr::vector<double>> obs; // one column per observation type
+    std::pmr::vector<std::pmr::vector<int64_t>> obs_fixed; // the same in 0.001 units
+    std::pmr::vector<std::pmr::vector<uint8_t>> flags; // LLI/SSI, parallel to obs
+
+    size_t num_epochs() const { return epoch_time.size(); }
+    size_t num_rows() const { return row_sat.size(); }
+    size_t rows_begin(size_t e) const { return epoch_begin[e]; }
+    size_t rows_end(size_t e) const { return e + 1 < epoch_begin.size() ? epoch_begin[e + 1] : row_sat.size(); }
+    double value(size_t row, size_t type) const {
+        return fixed_point ? from_fixed_point(obs_fixed[type][row]) : obs[type][row];
+    }
+    int64_t fixed_value(size_t row, size_t type) const {
+        return fixed_point ? obs_fixed[type][row] : to_fixed_point(obs[type][row]);
+    }
+    uint8_t flag(size_t row, size_t type) const { return flags[type][row]; }
+    CalendarTime epoch_calendar(size_t e) const { return calendar_from_gps_ns(epoch_time[e]); }
+
+    // index of sv in the satellite table, or -1 if it was never observed
+    int sat_index(SatId sv) const;
+
+    // rows of satellite sat_idx in epoch order, i.e. its whole arc
+    std::vector<uint32_t> sat_rows(int sat_idx) const;
+
+    // rows of observation type t whose LLI has any bit of mask set, e.g. the possible
+    // cycle slips with kLliSlipMask
+    std::vector<uint32_t> flagged_rows(size_t type, uint8_t mask) const;
+
+    // drop all epochs and size obs (or obs_fixed) and flags to one column per
+    // observation type
+    void reset_columns();
+
+    // make room for rows more rows without reallocating (which in an arena would leave
+    // the outgrown buffers behind)
+    void reserve_rows(size_t rows);
+
+    // append an epoch (its satellites become rows; its values are converted if it
+    // uses the other storage) / copy epoch e back out
+    void append(const ObsEpoch& ep);
+
+    // append all epochs of other, which must have the same obs_types and storage
+    void append(const RinexObs& other);
+    void epoch(size_t e, ObsEpoch& ep) const;
+
+    // rebuild the satellite lookup after sats was filled in directly
+    void index_sats();
+
+private:
+    std::pmr::vector<uint16_t> sat_lookup_; // SatId::index() -> satellite table index
 };
 
 // Enum representing possible error codes returned by the RINEX parser.
@@ -39,21 +170,81 @@ enum class ParseRinexError {
     MissingHeader,
     InvalidObsTypeCount,
     IncompatibleObsTypes,
-    NoEpochs
+    NoEpochs,
+    DecompressionFailed,
+    InvalidCache,
+    UnsupportedFormat,
+    Restarted
+};
+
+class AsyncReader;
+class ThreadPool;
+struct ParseStats;
+
+// options for parse_rinex_obs
+struct ParseOptions {
+    // Threads decoding the observation records; 0 uses one per core. The body is cut
+    // into chunks at epoch records, so each thread gets at least min_chunk_bytes.
+    unsigned threads = 1;
+    size_t min_chunk_bytes = 4 << 20;
+
+    // run the chunks on this pool instead of a pool of their own
+    ThreadPool* pool = nullptr;
+
+    // observation codes to decode, e.g., {"C1C", "L1C", "L2W"}; empty decodes all
+    std::vector<std::string> obs_codes;
+
+    // counters and stage timers to add to (see ParseStats.hpp); nullptr skips them
+    ParseStats* stats = nullptr;
+
+    // Store observations as int64 thousandths (RinexObs::obs_fixed) rather than doubles.
+    // The integers are exact, convert on access and skip the floating point division.
+    bool fixed_point = false;
+
+    // Stream plain files through an I/O thread that reads ahead into large buffers
+    // instead of mapping them, so that reading overlaps with decoding where page faults
+    // would stall the decoder for each round trip (network filesystems). The records
+    // are then decoded on one thread, as for compressed input.
+    bool io_thread = false;
+
+    // Stream files through this reader (see AsyncReader.hpp), which keeps many reads in
+    // flight across the files of a batch; like io_thread, each file is then decoded on
+    // one thread
+    AsyncReader* async_io = nullptr;
 };
 
+// The file is memory mapped and walked as string_view lines, so no line is copied
+// before it is decoded. Compressed and Compact RINEX files (and plain ones with
+// ParseOptions::io_thread or async_io) are streamed through their decoders instead
+// (and parsed on one thread). Use EpochReader to stream epochs instead of collecting
+// them.
 ParseRinexError parse_rinex_obs(const std::string& path, rinex::RinexObs& out);
+ParseRinexError parse_rinex_obs(const std::string& path, rinex::RinexObs& out,
+                                const ParseOptions& opts);
+
+// parse the header up to and including END OF HEADER, counting it into stats if given
+ParseRinexError parse_rinex_header(LineScanner& scanner, rinex::RinexHeader& hdr,
+                                   ParseStats* stats = nullptr);
 
-// The code currently parses only GPS for now
-bool is_gps_sat(const std::string &sv);
+// Restrict decoding to the observation codes in codes. obs_types becomes the requested
+// codes that the file has, in the order requested, and only their slots are converted;
+// the others are skipped by offset. Returns IncompatibleObsTypes if the file has none
+// of them. An empty list selects every type again.
+ParseRinexError select_obs_types(rinex::RinexHeader& hdr, const std::vector<std::string>& codes);
+
+// True for GPS satellite ids, including RINEX 2 ids without a system letter
+bool is_gps_sat(std::string_view sv);
 
 // remove leading and trailing whitespace, tabs, and newlines from a string 
-std::string trim(const std::string &s); 
+std::string trim(std::string_view s); 
+
+// same as trim, but returns a view into s instead of a copy
+std::string_view trim_view(std::string_view s);
 
 // extract obs types from the header using space-based split, filtering for valid types.
 // This function works for both RINEX versions 2 and 3. 
 std::vector<std::string> extract_obs_types_from_line(
-    const std::string& line,
+    std::string_view line,
     size_t skip_chars,
     int min_len,
     int max_len,
@@ -61,15 +252,16 @@ std::vector<std::string> extract_obs_types_from_line(
   );
 
 // returns true if the string represents a valid floating point number
-bool is_number(const std::string &s);
+bool is_number(std::string_view s);
 
-// edit RINEX2 satellite IDs to conform to RINEX3 standard
-std::string normalize_sat_id(const std::string &sv);
+// edit RINEX2 satellite IDs to conform to RINEX3 standard. The parser itself works
+// on SatId::parse and never builds these strings.
+std::string normalize_sat_id(std::string_view sv);
 
 // True if the RINEX file is version 3
-bool is_rinex_v3(const std::string& line);
+bool is_rinex_v3(std::string_view line);
 
 // The observation type line should list the number of expected observation types 
-int parse_obs_type_count(const std::string& line);
+int parse_obs_type_count(std::string_view line);
 
 } // end namespace rinex 
\ No newline at end of file
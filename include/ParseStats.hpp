@@ -0,0 +1,53 @@
+// ParseStats.hpp
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace rinex {
+
+// Counters and stage timers of one or more parses, filled in when a ParseStats is
+// passed in ParseOptions::stats (or EpochReader::set_stats). Without one the decoder
+// runs code compiled without any of the instrumentation, so it costs nothing.
+//
+// The stage timers add up the time spent in each stage. A file decoded in chunks on
+// several threads reports the sum over the threads, which can exceed total_ns.
+struct ParseStats {
+  uint64_t files = 0;
+  uint64_t bytes = 0;             // input bytes as stored (compressed size for compressed input)
+  uint64_t text_bytes = 0;        // RINEX text decoded, after any decompression
+  uint64_t lines = 0;             // text lines read, header included
+  uint64_t header_lines = 0;
+  uint64_t comment_lines = 0;     // COMMENT records in the header
+  uint64_t epochs = 0;            // epochs decoded
+  uint64_t event_records = 0;     // event flag 2-5 records and the header lines they carry
+  uint64_t dropped_epochs = 0;    // epochs cut short by the end of input or the next epoch
+  uint64_t stray_lines = 0;       // lines outside any epoch that were skipped
+  uint64_t satellites = 0;        // satellite records decoded into rows
+  uint64_t skipped_satellites = 0; // records of systems without selected types
+  uint64_t fields_decoded = 0;    // observation slots converted
+  uint64_t fields_skipped = 0;    // slots passed over because their type was not selected
+  uint64_t allocations = 0;       // growths of the epoch buffer and the result arrays
+
+  // nanoseconds per stage
+  int64_t header_ns = 0;          // header records, up to END OF HEADER
+  int64_t epoch_ns = 0;           // epoch records, with RINEX 2 satellite lists
+  int64_t obs_ns = 0;             // satellite observation records
+  int64_t assemble_ns = 0;        // appending epochs to the result and merging chunks
+  int64_t total_ns = 0;           // wall time of parse calls
+
+  // add the counts and times of other
+  void merge(const ParseStats& other);
+
+  // one flat JSON object, e.g. {"files":1,"bytes":9487584,...,"total_ns":17412345}
+  std::string to_json() const;
+};
+
+// monotonic clock for the stage timers, in ns
+inline int64_t stats_clock_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // end namespace rinex
@@ -0,0 +1,94 @@
+// RinexFollower.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "ParseRinex.hpp"
+
+namespace rinex {
+
+// Follows a plain RINEX observation file that is still being written, e.g. an hourly
+// file a receiver appends 1 Hz epochs to. The header is parsed once it is complete;
+// after that each poll() reads only the bytes appended since the previous one and
+// hands every newly completed epoch to a callback:
+//
+//   RinexFollower follower;
+//   follower.open(path);
+//   while (running) {
+//     follower.wait(1000);  // until the file grows, or one second at most
+//     follower.poll([&](const ObsEpoch& ep) { process(ep); });
+//   }
+//
+// Only bytes up to the last newline are decoded, and an epoch is emitted once all of
+// its records are there; the text of a partial epoch is kept until the next poll.
+//
+// A file that is rewritten is followed again from its header: one that shrinks, one
+// replaced at path by another file (e.g. renamed over it), and one overwritten in
+// place, whose last bytes read have changed or which stayed modified without growing
+// over two polls and no longer hashes the same. The poll that notices returns
+// Restarted without calling back; drop what was received (the header may differ too)
+// and poll again to get the epochs from the start of the new text.
+class RinexFollower {
+public:
+  using EpochCallback = std::function<void(const ObsEpoch&)>;
+
+  RinexFollower() = default;
+  ~RinexFollower() { close(); }
+
+  RinexFollower(const RinexFollower&) = delete;
+  RinexFollower& operator=(const RinexFollower&) = delete;
+
+  // Open path for following. Of opts only obs_codes, stats and fixed_point are used. The file may still be
+  // empty; FileNotFound if it cannot be opened.
+  ParseRinexError open(const std::string& path, const ParseOptions& opts = ParseOptions());
+  void close();
+
+  // Decode what was appended since the last call, calling fn for each new complete
+  // epoch in file order. Returns Success also when there was nothing new (see
+  // header_ready()), Restarted once for a rewritten file, and the header parse error
+  // for a file whose header is complete but invalid. Compressed or Compact RINEX
+  // files give UnsupportedFormat.
+  ParseRinexError poll(const EpochCallback& fn);
+
+  // Block until the file is written to or timeout_ms passes (inotify on Linux,
+  // otherwise a sleep). True if the file may have grown.
+  bool wait(int timeout_ms);
+
+  bool header_ready() const { return header_ready_; }
+  const RinexHeader& header() const { return header_; }
+
+  // file offset up to which epochs have been emitted
+  uint64_t offset() const { return consumed_; }
+  size_t epochs() const { return epochs_; }
+
+private:
+  ParseRinexError poll_file(const EpochCallback& fn);
+  bool open_file(const std::string& path);
+  void restart();
+  uint64_t file_size() const;
+  bool file_stat(uint64_t& size, int64_t& mtime) const;
+  bool replaced() const;
+  bool rewritten(uint64_t size, int64_t mtime);
+
+  // bytes before the read position compared on each poll to notice in-place rewrites
+  static constexpr size_t kTailBytes = 64;
+
+  std::string path_;
+  ParseOptions opts_;
+  int fd_ = -1;
+  int notify_fd_ = -1;
+  RinexHeader header_;
+  bool header_ready_ = false;
+  uint64_t consumed_ = 0;       // file offset of pending_[0]
+  std::string pending_;         // bytes read but not yet part of an emitted epoch
+  std::string tail_;            // the last bytes read, up to kTailBytes
+  uint64_t read_hash_ = 0;      // of all bytes read
+  int64_t read_mtime_ = 0;      // modification time when they were read
+  int64_t unchanged_mtime_ = 0; // of the last poll that found it modified but not grown
+  size_t epochs_ = 0;
+  ObsEpoch epoch_; // reused for every epoch
+};
+
+} // end namespace rinex
@@ -0,0 +1,119 @@
+// SatId.hpp
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace rinex {
+
+// GNSS constellations, numbered so that they can index small lookup tables
+enum class GnssSystem : uint8_t {
+  Unknown = 0,
+  GPS,
+  GLONASS,
+  Galileo,
+  BeiDou,
+  QZSS,
+  IRNSS,
+  SBAS
+};
+
+constexpr size_t kNumSystems = 8;
+
+// RINEX system letter of each GnssSystem, indexed by its value
+constexpr char kSystemLetters[kNumSystems + 1] = "?GRECJIS";
+
+constexpr char system_letter(GnssSystem sys) {
+  return kSystemLetters[(size_t)sys < kNumSystems ? (size_t)sys : 0];
+}
+
+// system of a RINEX system letter; a blank means GPS in RINEX 2
+constexpr GnssSystem system_from_letter(char c) {
+  switch (c) {
+    case 'G': case ' ': return GnssSystem::GPS;
+    case 'R': return GnssSystem::GLONASS;
+    case 'E': return GnssSystem::Galileo;
+    case 'C': return GnssSystem::BeiDou;
+    case 'J': return GnssSystem::QZSS;
+    case 'I': return GnssSystem::IRNSS;
+    case 'S': return GnssSystem::SBAS;
+    default: return GnssSystem::Unknown;
+  }
+}
+
+// Compact satellite identifier: constellation in the high byte, PRN (as written
+// in RINEX, 1-99) in the low byte. Cheap to copy, compare and hash, and index()
+// maps it onto a dense range for direct array lookups.
+class SatId {
+public:
+  static constexpr int kMaxPrn = 100;
+  static constexpr size_t kIndexCount = kNumSystems * kMaxPrn;
+
+  constexpr SatId() = default;
+  constexpr SatId(GnssSystem sys, int prn)
+      : code_((uint16_t)(((unsigned)sys << 8) | ((unsigned)prn & 0xffu))) {}
+
+  constexpr GnssSystem system() const { return (GnssSystem)(code_ >> 8); }
+  constexpr int prn() const { return code_ & 0xff; }
+  constexpr char letter() const { return system_letter(system()); }
+  constexpr uint16_t code() const { return code_; }
+  constexpr bool valid() const { return system() != GnssSystem::Unknown && prn() > 0; }
+
+  // dense index in [0, kIndexCount)
+  constexpr size_t index() const {
+    return (size_t)system() * kMaxPrn + (size_t)(prn() < kMaxPrn ? prn() : 0);
+  }
+
+  // Parse "G05", "G 5", "R12" (RINEX 3 and 2) or " 5", "05", "5" (RINEX 2 GPS).
+  // Surrounding blanks are ignored. Returns an invalid SatId on failure.
+  static constexpr SatId parse(std::string_view s) {
+    size_t b = 0, e = s.size();
+    while (b < e && s[b] == ' ') ++b;
+    while (e > b && s[e - 1] == ' ') --e;
+    if (b == e) return SatId();
+    GnssSystem sys = GnssSystem::GPS;
+    if (s[b] < '0' || s[b] > '9') {
+      sys = system_from_letter(s[b]);
+      if (sys == GnssSystem::Unknown) return SatId();
+      ++b;
+      while (b < e && s[b] == ' ') ++b;
+    }
+    if (b == e || e - b > 2) return SatId();
+    int prn = 0;
+    for (; b < e; ++b) {
+      if (s[b] < '0' || s[b] > '9') return SatId();
+      prn = prn * 10 + (s[b] - '0');
+    }
+    if (prn == 0) return SatId();
+    return SatId(sys, prn);
+  }
+
+  // RINEX 3 form, e.g., "G05"
+  std::string to_string() const {
+    char buf[3] = {letter(), (char)('0' + prn() / 10 % 10), (char)('0' + prn() % 10)};
+    return std::string(buf, 3);
+  }
+
+  friend constexpr bool operator==(SatId a, SatId b) { return a.code_ == b.code_; }
+  friend constexpr bool operator!=(SatId a, SatId b) { return a.code_ != b.code_; }
+  friend constexpr bool operator<(SatId a, SatId b) { return a.code_ < b.code_; }
+
+private:
+  uint16_t code_ = 0;
+};
+
+static_assert(sizeof(SatId) == 2, "SatId must stay 16 bits");
+static_assert(SatId::parse("G05") == SatId(GnssSystem::GPS, 5), "RINEX 3 id");
+static_assert(SatId::parse(" 5") == SatId(GnssSystem::GPS, 5), "RINEX 2 id");
+static_assert(SatId::parse("R 7") == SatId(GnssSystem::GLONASS, 7), "RINEX 2 id with blank");
+
+} // end namespace rinex
+
+namespace std {
+template <>
+struct hash<rinex::SatId> {
+  size_t operator()(rinex::SatId s) const noexcept { return s.code(); }
+};
+} // end namespace std
@@ -0,0 +1,103 @@
+// SpscQueue.hpp
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace rinex {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread. The slots
+// form a ring of a power of two; the producer only writes tail_, the consumer only
+// head_, each on a cache line of its own, and each side keeps a cached copy of the
+// other's index so that it touches the shared line only when the ring looks full (or
+// empty). Neither side ever blocks; waiting is left to the caller.
+template <typename T>
+class SpscQueue {
+public:
+  explicit SpscQueue(size_t capacity) {
+    size_t n = 1;
+    while (n < capacity) n <<= 1;
+    mask_ = n - 1;
+    slots_.reset(new T[n]);
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // producer: false if the queue is full
+  bool try_push(T v) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) return false;
+    }
+    slots_[tail & mask_] = std::move(v);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer: false if the queue is empty
+  bool try_pop(T& v) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return false;
+    }
+    v = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // from either side; exact only when the other side is idle
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  alignas(64) std::atomic<size_t> head_{0}; // next slot to pop
+  size_t tail_cache_ = 0;                   // consumer's view of tail_
+  alignas(64) std::atomic<size_t> tail_{0}; // next slot to push
+  size_t head_cache_ = 0;                   // producer's view of head_
+  alignas(64) size_t mask_ = 0;
+  std::unique_ptr<T[]> slots_;
+};
+
+// Lets the two sides of lock-free queues sleep when there is nothing to do. A waiter
+// spins (yielding) for a while, then announces itself in waiters_ before its last
+// check; notify() reads waiters_ after the change it publishes. Both do so with a
+// read-modify-write, so if notify() comes first in the order of waiters_ the waiter
+// sees the change, and otherwise notify() sees the waiter. Uncontended, notify() costs
+// one atomic add and no lock.
+class EventCount {
+public:
+  template <typename Ready>
+  void wait_until(Ready ready) {
+    for (int i = 0; i < 64; ++i) {
+      if (ready()) return;
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters_.fetch_add(1, std::memory_order_acq_rel);
+    cv_.wait(lock, ready);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // wake every waiter, after the change it waits for was made
+  void notify() {
+    if (waiters_.fetch_add(0, std::memory_order_acq_rel) == 0) return;
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    cv_.notify_all();
+  }
+
+private:
+  std::atomic<int> waiters_{0};
+  std::mutex mutex_; // only to sleep on cv_
+  std::condition_variable cv_;
+};
+
+} // end namespace rinex
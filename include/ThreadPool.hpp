@@ -0,0 +1,76 @@
+// ThreadPool.hpp
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rinex {
+
+// Work-stealing thread pool. Every worker owns a deque: tasks submitted from a worker
+// go to the back of its own deque and are taken from there (newest first, while
+// their data is still in cache), and an idle worker steals the oldest task of another
+// worker. A file task that splits itself into chunk tasks therefore keeps the chunks
+// local unless other workers run dry.
+//
+// Tasks are counted in a TaskGroup; wait() runs queued tasks of that group on the
+// calling thread until the group is done, so tasks may themselves submit and wait on
+// sub-tasks without picking up unrelated work (say, a whole file) in the meantime.
+class ThreadPool {
+public:
+  // outstanding tasks of one batch
+  class TaskGroup {
+  public:
+    bool done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+  private:
+    friend class ThreadPool;
+    std::atomic<size_t> pending_{0}; // queued or running
+    std::atomic<size_t> queued_{0};
+  };
+
+  // threads = 0 starts one worker per core
+  explicit ThreadPool(unsigned threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const { return workers_.size(); }
+
+  void submit(TaskGroup& group, std::function<void()> fn);
+
+  // return once every task of group has finished, running tasks meanwhile
+  void wait(TaskGroup& group);
+
+private:
+  struct Task {
+    std::function<void()> fn;
+    TaskGroup* group = nullptr;
+  };
+  struct Queue {
+    std::mutex m;
+    std::deque<Task> tasks;
+  };
+
+  void worker_loop(size_t self);
+  bool pop(size_t self, Task& task);
+  bool pop_group(size_t self, const TaskGroup& group, Task& task);
+  void run(Task& task);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<size_t> next_queue_{0};
+  std::mutex m_;
+  std::condition_variable work_cv_; // tasks were queued
+  std::condition_variable done_cv_; // a group may have finished
+  bool stop_ = false;
+};
+
+} // end namespace rinex
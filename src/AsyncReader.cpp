@@ -0,0 +1,446 @@
+// File:   AsyncReader.cpp
+// Description:
+// Read-ahead of many files at once through io_uring, with a pread fallback.
+//
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#include "../include/AsyncReader.hpp"
+
+#ifdef RINEX_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace rinex {
+
+static constexpr size_t kPageSize = 4096;
+
+struct FreeBuffer {
+  void operator()(char* p) const { std::free(p); }
+};
+
+struct AsyncBlock {
+  uint32_t index; // into Stream::buffers
+  size_t size;
+};
+
+// one open file: its buffers, the reads in flight and the queues to its source
+struct AsyncReader::Stream {
+  struct Buffer {
+    std::unique_ptr<char, FreeBuffer> data;
+    Stream* owner = nullptr;
+    uint32_t index = 0;
+    uint64_t offset = 0; // file offset of data[0]
+    size_t want = 0;     // bytes to read into it
+    size_t got = 0;
+    bool done = false;   // read complete, waiting for the buffers before it
+    iovec iov = {};
+  };
+
+  Stream(int fd, uint64_t size, size_t buffer_size, size_t count)
+      : fd(fd), size(size), end_offset(size), buffers(count), full(count), empty(count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      buffers[i].data.reset(static_cast<char*>(std::aligned_alloc(kPageSize, buffer_size)));
+      buffers[i].owner = this;
+      buffers[i].index = i;
+      spare.push_back(i);
+    }
+  }
+  ~Stream() { ::close(fd); }
+
+  // I/O thread only
+  int fd;
+  uint64_t size;
+  uint64_t next_offset = 0; // of the next read to issue
+  uint64_t end_offset;      // data ends here (lowered by an error or a shrunk file)
+  unsigned in_flight = 0;
+  std::vector<Buffer> buffers;
+  std::vector<uint32_t> spare;  // buffers free to read into
+  std::deque<uint32_t> pending; // buffers read or being read, in file order
+
+  SpscQueue<AsyncBlock> full; // I/O thread -> source, in file order
+  SpscQueue<uint32_t> empty;  // source -> I/O thread
+  std::atomic<bool> done{false}; // every block has been queued
+  std::atomic<bool> failed{false};
+  std::atomic<bool> closed{false}; // the source went away
+};
+
+#ifdef RINEX_HAVE_IO_URING
+
+// The submission and completion rings, mapped from the kernel. Only the I/O thread
+// touches them; the kernel's side of each ring is read with acquire and ours published
+// with release ordering.
+struct AsyncReader::Ring {
+  ~Ring() {
+    if (sqes) munmap(sqes, sqes_len);
+    if (cq_ptr && cq_ptr != sq_ptr) munmap(cq_ptr, cq_len);
+    if (sq_ptr) munmap(sq_ptr, sq_len);
+    if (fd >= 0) ::close(fd);
+  }
+
+  static std::unique_ptr<Ring> create(unsigned entries) {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    std::unique_ptr<Ring> r(new Ring());
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) return nullptr;
+
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) r->sq_len = r->cq_len = std::max(r->sq_len, r->cq_len);
+    r->sq_ptr = mmap(nullptr, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+                     IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED) {
+      r->sq_ptr = nullptr;
+      return nullptr;
+    }
+    r->cq_ptr = single ? r->sq_ptr
+                       : mmap(nullptr, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              r->fd, IORING_OFF_CQ_RING);
+    if (r->cq_ptr == MAP_FAILED) {
+      r->cq_ptr = nullptr;
+      return nullptr;
+    }
+    r->sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return nullptr;
+    r->sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(r->sq_ptr);
+    char* cq = static_cast<char*>(r->cq_ptr);
+    r->sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    r->sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    r->sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    r->cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    r->cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    r->cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    r->cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    r->entries = p.sq_entries;
+    return r;
+  }
+
+  // queue a readv of b's remaining bytes
+  void read(Stream::Buffer& b, int fd) {
+    unsigned tail = *sq_tail;
+    unsigned i = tail & sq_mask;
+    io_uring_sqe& sqe = sqes[i];
+    memset(&sqe, 0, sizeof(sqe));
+    b.iov.iov_base = b.data.get() + b.got;
+    b.iov.iov_len = b.want - b.got;
+    sqe.opcode = IORING_OP_READV; // READV rather than READ: available since the first io_uring kernels
+    sqe.fd = fd;
+    sqe.off = b.offset + b.got;
+    sqe.addr = (uint64_t)(uintptr_t)&b.iov;
+    sqe.len = 1;
+    sqe.user_data = (uint64_t)(uintptr_t)&b;
+    sq_array[i] = i;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++to_submit;
+  }
+
+  // submit the queued reads and wait for at least min_complete completions
+  int enter(unsigned min_complete) {
+    while (true) {
+      int r = (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                           min_complete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+      if (r >= 0) {
+        to_submit -= std::min<unsigned>(to_submit, (unsigned)r);
+        return 0;
+      }
+      if (errno != EINTR) return -errno;
+    }
+  }
+
+  // call fn(buffer, result) for each completion
+  template <typename Fn>
+  unsigned reap(Fn fn) {
+    unsigned head = *cq_head, n = 0;
+    unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head, ++n) {
+      const io_uring_cqe& cqe = cqes[head & cq_mask];
+      fn(*reinterpret_cast<Stream::Buffer*>((uintptr_t)cqe.user_data), (int64_t)cqe.res);
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    return n;
+  }
+
+  int fd = -1;
+  unsigned entries = 0;
+  unsigned to_submit = 0;
+  void* sq_ptr = nullptr;
+  size_t sq_len = 0;
+  void* cq_ptr = nullptr;
+  size_t cq_len = 0;
+  io_uring_sqe* sqes = nullptr;
+  size_t sqes_len = 0;
+  unsigned* sq_tail = nullptr;
+  unsigned sq_mask = 0;
+  unsigned* sq_array = nullptr;
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  io_uring_cqe* cqes = nullptr;
+};
+
+#else
+
+// built without io_uring: never created, every read goes through pread
+struct AsyncReader::Ring {
+  static std::unique_ptr<Ring> create(unsigned) { return nullptr; }
+  void read(Stream::Buffer&, int) {}
+  int enter(unsigned) { return -ENOSYS; }
+  template <typename Fn> unsigned reap(Fn) { return 0; }
+  unsigned entries = 0;
+  unsigned to_submit = 0;
+};
+
+#endif
+
+// The decoder's end of a stream: hands out the completed buffers in file order and
+// gives each one back once it has been copied out.
+class AsyncSource : public ByteSource {
+public:
+  AsyncSource(AsyncReader* reader, std::shared_ptr<AsyncReader::Stream> stream)
+      : reader_(reader), stream_(std::move(stream)) {}
+
+  ~AsyncSource() override {
+    stream_->closed.store(true, std::memory_order_release);
+    reader_->io_event_.notify();
+  }
+
+  size_t read(char* buf, size_t n) override {
+    AsyncReader::Stream& s = *stream_;
+    if (!have_current_ || pos_ == current_.size) {
+      if (have_current_) {
+        s.empty.try_push(current_.index);
+        have_current_ = false;
+        reader_->io_event_.notify();
+      }
+      while (!s.full.try_pop(current_)) {
+        if (s.done.load(std::memory_order_acquire) && s.full.empty()) return 0;
+        reader_->reader_event_.wait_until(
+            [&] { return s.done.load(std::memory_order_acquire) || !s.full.empty(); });
+      }
+      have_current_ = true;
+      pos_ = 0;
+    }
+    size_t k = std::min(n, current_.size - pos_);
+    memcpy(buf, s.buffers[current_.index].data.get() + pos_, k);
+    pos_ += k;
+    return k;
+  }
+
+  bool failed() const override { return stream_->failed.load(std::memory_order_acquire); }
+
+private:
+  AsyncReader* reader_;
+  std::shared_ptr<AsyncReader::Stream> stream_;
+  AsyncBlock current_ = {0, 0};
+  bool have_current_ = false;
+  size_t pos_ = 0;
+};
+
+AsyncReader::AsyncReader(unsigned queue_depth, size_t buffer_size, size_t buffers_per_file)
+    : buffer_size_((std::max<size_t>(buffer_size, 1) + kPageSize - 1) & ~(kPageSize - 1)),
+      buffers_per_file_(std::max<size_t>(buffers_per_file, 2)),
+      queue_depth_(std::max(queue_depth, 1u)),
+      ring_(Ring::create(std::max(queue_depth, 1u))) {
+  if (ring_) queue_depth_ = std::min(queue_depth_, ring_->entries);
+  use_ring_.store(ring_ != nullptr, std::memory_order_relaxed);
+  thread_ = std::thread(&AsyncReader::run, this);
+}
+
+AsyncReader::~AsyncReader() {
+  stop_.store(true, std::memory_order_release);
+  io_event_.notify();
+  thread_.join();
+  for (char* p : retired_) std::free(p);
+}
+
+std::unique_ptr<ByteSource> AsyncReader::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  auto stream = std::make_shared<Stream>(fd, (uint64_t)st.st_size, buffer_size_, buffers_per_file_);
+  {
+    std::lock_guard<std::mutex> lock(open_mutex_);
+    opened_.push_back(stream);
+    have_opened_.store(true, std::memory_order_release);
+  }
+  io_event_.notify();
+  return std::make_unique<AsyncSource>(this, std::move(stream));
+}
+
+// Start reads into the free buffers of s, up to the queue depth; false if none could be
+// started. With the pread fallback the reads are done right here.
+bool AsyncReader::issue(Stream& s) {
+  bool issued = false;
+  while (!s.closed.load(std::memory_order_acquire) && s.next_offset < s.end_offset &&
+         (!ring_ || in_flight_ < queue_depth_)) {
+    uint32_t index;
+    if (!s.spare.empty()) {
+      index = s.spare.back();
+      s.spare.pop_back();
+    } else if (!s.empty.try_pop(index)) {
+      break;
+    }
+    Stream::Buffer& b = s.buffers[index];
+    b.offset = s.next_offset;
+    b.want = (size_t)std::min<uint64_t>(buffer_size_, s.end_offset - b.offset);
+    b.got = 0;
+    b.done = false;
+    s.next_offset += b.want;
+    s.pending.push_back(index);
+    ++s.in_flight;
+    issued = true;
+    if (ring_) {
+      ring_->read(b, s.fd);
+      ++in_flight_;
+      continue;
+    }
+    read_now(s, index);
+  }
+  return issued;
+}
+
+// read the rest of buffer index of s with pread
+void AsyncReader::read_now(Stream& s, uint32_t index) {
+  Stream::Buffer& b = s.buffers[index];
+  while (true) {
+    ssize_t r = pread(s.fd, b.data.get() + b.got, b.want - b.got, (off_t)(b.offset + b.got));
+    if (r < 0 && errno == EINTR) continue;
+    if (complete(s, index, r < 0 ? -errno : (int64_t)r)) break;
+  }
+}
+
+// The ring is unusable: go on with pread. Reads submitted to it may still land until
+// the kernel has torn it down, so their buffers are swapped for new ones and kept
+// until the reader goes away.
+void AsyncReader::drop_ring() {
+  ring_.reset();
+  use_ring_.store(false, std::memory_order_release);
+  in_flight_ = 0;
+  for (const auto& s : streams_) {
+    for (uint32_t index : s->pending) {
+      Stream::Buffer& b = s->buffers[index];
+      if (b.done) continue;
+      std::unique_ptr<char, FreeBuffer> fresh(
+          static_cast<char*>(std::aligned_alloc(kPageSize, buffer_size_)));
+      memcpy(fresh.get(), b.data.get(), b.got);
+      retired_.push_back(b.data.release());
+      b.data = std::move(fresh);
+      read_now(*s, index);
+    }
+  }
+}
+
+// A read into buffer index of s returned result (bytes or -errno). Returns false if the
+// buffer is still short and has to be read further (with the ring, that read is
+// already queued).
+bool AsyncReader::complete(Stream& s, uint32_t index, int64_t result) {
+  Stream::Buffer& b = s.buffers[index];
+  if (result > 0) b.got += (size_t)result;
+  if (result > 0 && b.got < b.want) {
+    if (ring_) ring_->read(b, s.fd);
+    return false;
+  }
+  if (result < 0) s.failed.store(true, std::memory_order_release);
+  // an error, or the end of a file that shrank: the data stops here
+  if (result <= 0) s.end_offset = std::min<uint64_t>(s.end_offset, b.offset + b.got);
+  b.done = true;
+  --s.in_flight;
+  return true;
+}
+
+// queue the completed buffers at the front of s for its source, in file order
+void AsyncReader::deliver(Stream& s) {
+  while (!s.pending.empty() && s.buffers[s.pending.front()].done) {
+    uint32_t index = s.pending.front();
+    s.pending.pop_front();
+    const Stream::Buffer& b = s.buffers[index];
+    size_t n = b.offset >= s.end_offset ? 0 : (size_t)std::min<uint64_t>(b.got, s.end_offset - b.offset);
+    if (n > 0) {
+      s.full.try_push(AsyncBlock{index, n}); // there are no more blocks than slots
+      delivered_ = true;
+    } else {
+      s.spare.push_back(index); // read past the end of the data
+    }
+  }
+  if (s.in_flight == 0 && s.pending.empty() && s.next_offset >= s.end_offset &&
+      !s.done.load(std::memory_order_relaxed)) {
+    s.done.store(true, std::memory_order_release);
+    delivered_ = true;
+  }
+}
+
+// true if the I/O thread has something to do besides waiting for completions
+bool AsyncReader::can_progress() const {
+  if (stop_.load(std::memory_order_acquire) || have_opened_.load(std::memory_order_acquire)) return true;
+  for (const auto& s : streams_) {
+    if (s->closed.load(std::memory_order_acquire)) return true;
+    if (s->next_offset < s->end_offset && !s->empty.empty()) return true;
+  }
+  return false;
+}
+
+void AsyncReader::run() {
+  while (true) {
+    if (have_opened_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(open_mutex_);
+      streams_.insert(streams_.end(), opened_.begin(), opened_.end());
+      opened_.clear();
+      have_opened_.store(false, std::memory_order_relaxed);
+    }
+    bool stopping = stop_.load(std::memory_order_acquire);
+    bool issued = false;
+    delivered_ = false;
+    for (const auto& s : streams_) {
+      if (!stopping) issued |= issue(*s);
+      deliver(*s);
+    }
+    if (delivered_) reader_event_.notify();
+    // forget finished or abandoned files once none of their reads is in flight
+    streams_.erase(std::remove_if(streams_.begin(), streams_.end(),
+                                  [](const std::shared_ptr<Stream>& s) {
+                                    return s->in_flight == 0 &&
+                                           (s->done.load(std::memory_order_relaxed) ||
+                                            s->closed.load(std::memory_order_acquire));
+                                  }),
+                   streams_.end());
+    if (stopping && in_flight_ == 0) return;
+
+    if (ring_ && in_flight_ > 0) {
+      int err = ring_->enter(1);
+      if (err < 0 && err != -EAGAIN && err != -EBUSY) {
+        drop_ring();
+        continue;
+      }
+      ring_->reap([&](Stream::Buffer& b, int64_t result) {
+        --in_flight_;
+        if (!complete(*b.owner, b.index, result)) ++in_flight_; // the rest was queued
+      });
+      continue;
+    }
+    if (!issued) io_event_.wait_until([&] { return can_progress(); });
+  }
+}
+
+} // end namespace rinex
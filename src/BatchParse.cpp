@@ -0,0 +1,71 @@
+// File:   BatchParse.cpp
+// Description:
+// Parse lists of RINEX files on a shared work-stealing thread pool.
+//
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+#include "../include/BatchParse.hpp"
+#include "../include/ParseStats.hpp"
+#include "../include/ThreadPool.hpp"
+
+namespace rinex {
+
+void parse_rinex_batch(const std::vector<std::string>& paths, const BatchSink& sink,
+                       const ParseOptions& opts) {
+  std::unique_ptr<ThreadPool> own_pool;
+  ThreadPool* pool = opts.pool;
+  if (!pool) {
+    // the default of one thread is meant for a single file; a batch uses every core
+    own_pool.reset(new ThreadPool(opts.threads == 1 ? 0 : opts.threads));
+    pool = own_pool.get();
+  }
+
+  // largest first, so that a big file does not start last and finish alone
+  std::vector<uint64_t> sizes(paths.size(), 0);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    int64_t mtime;
+    file_stamp(paths[i], sizes[i], mtime);
+  }
+  std::vector<size_t> order(paths.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+  ParseOptions file_opts = opts;
+  file_opts.pool = pool;
+  std::mutex sink_mutex;
+  ThreadPool::TaskGroup group;
+  for (size_t i : order) {
+    pool->submit(group, [&, i]() {
+      // files count into stats of their own, added to opts.stats with the sink call
+      ParseStats file_stats;
+      ParseOptions task_opts = file_opts;
+      if (opts.stats) task_opts.stats = &file_stats;
+      RinexObs obs;
+      ParseRinexError err = parse_rinex_obs(paths[i], obs, task_opts);
+      std::lock_guard<std::mutex> lock(sink_mutex);
+      if (opts.stats) opts.stats->merge(file_stats);
+      sink(i, paths[i], err, obs);
+    });
+  }
+  pool->wait(group);
+}
+
+std::vector<BatchResult> parse_rinex_batch(const std::vector<std::string>& paths,
+                                           const ParseOptions& opts) {
+  std::vector<BatchResult> results(paths.size());
+  parse_rinex_batch(
+      paths,
+      [&](size_t index, const std::string& path, ParseRinexError error, RinexObs& obs) {
+        results[index].path = path;
+        results[index].error = error;
+        results[index].obs = std::move(obs);
+      },
+      opts);
+  return results;
+}
+
+} // end namespace rinex
@@ -0,0 +1,177 @@
+// File:   ByteSource.cpp
+// Description:
+// File, prefix and read-ahead byte sources, and detection of compressed input.
+//
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "../include/AsyncReader.hpp"
+#include "../include/ByteSource.hpp"
+#include "../include/Decompress.hpp"
+
+namespace rinex {
+
+static constexpr size_t kPageSize = 4096;
+
+FileSource::FileSource(const std::string& path) {
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ >= 0) posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL); // larger kernel read-ahead
+}
+
+FileSource::~FileSource() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+size_t FileSource::read(char* buf, size_t n) {
+  if (fd_ < 0) return 0;
+  while (true) {
+    ssize_t r = ::read(fd_, buf, n);
+    if (r >= 0) return (size_t)r;
+    if (errno == EINTR) continue;
+    failed_ = true;
+    return 0;
+  }
+}
+
+size_t PrefixedSource::read(char* buf, size_t n) {
+  if (pos_ < prefix_.size()) {
+    size_t k = std::min(n, prefix_.size() - pos_);
+    memcpy(buf, prefix_.data() + pos_, k);
+    pos_ += k;
+    return k;
+  }
+  return src_->read(buf, n);
+}
+
+ThreadedSource::ThreadedSource(std::unique_ptr<ByteSource> src, size_t buffer_size,
+                               size_t num_buffers)
+    : src_(std::move(src)),
+      buffer_size_((std::max<size_t>(buffer_size, 1) + kPageSize - 1) & ~(kPageSize - 1)),
+      full_(std::max<size_t>(num_buffers, 2)),
+      empty_(std::max<size_t>(num_buffers, 2)) {
+  // at least double buffering: one buffer being filled while another is read
+  for (uint32_t i = 0; i < std::max<size_t>(num_buffers, 2); ++i) {
+    buffers_.emplace_back(static_cast<char*>(std::aligned_alloc(kPageSize, buffer_size_)));
+    empty_.try_push(i);
+  }
+  thread_ = std::thread(&ThreadedSource::run, this);
+}
+
+ThreadedSource::~ThreadedSource() {
+  stop_.store(true, std::memory_order_release);
+  event_.notify();
+  thread_.join();
+}
+
+void ThreadedSource::run() {
+  while (true) {
+    uint32_t index;
+    while (!empty_.try_pop(index)) {
+      if (stop_.load(std::memory_order_acquire)) return;
+      event_.wait_until([&] { return stop_.load(std::memory_order_acquire) || !empty_.empty(); });
+    }
+    // fill the whole buffer, so the source sees few large reads
+    char* buf = buffers_[index].get();
+    size_t n = 0;
+    while (n < buffer_size_ && !stop_.load(std::memory_order_relaxed)) {
+      size_t k = src_->read(buf + n, buffer_size_ - n);
+      if (k == 0) break;
+      n += k;
+    }
+    if (n > 0) full_.try_push(Block{index, n}); // there are no more blocks than slots
+    if (n < buffer_size_) {
+      failed_.store(src_->failed(), std::memory_order_release);
+      done_.store(true, std::memory_order_release);
+      event_.notify();
+      return;
+    }
+    event_.notify();
+  }
+}
+
+size_t ThreadedSource::read(char* buf, size_t n) {
+  if (!have_current_ || current_pos_ == current_.size) {
+    if (have_current_) {
+      empty_.try_push(current_.index);
+      have_current_ = false;
+      event_.notify();
+    }
+    // blocks queued before done_ was set are still delivered
+    while (!full_.try_pop(current_)) {
+      if (done_.load(std::memory_order_acquire) && full_.empty()) return 0;
+      event_.wait_until([&] { return done_.load(std::memory_order_acquire) || !full_.empty(); });
+    }
+    have_current_ = true;
+    current_pos_ = 0;
+  }
+  size_t k = std::min(n, current_.size - current_pos_);
+  memcpy(buf, buffers_[current_.index].get() + current_pos_, k);
+  current_pos_ += k;
+  return k;
+}
+
+InputFormat detect_input_format(std::string_view head) {
+  if (head.size() >= 2 && (unsigned char)head[0] == 0x1f) {
+    if ((unsigned char)head[1] == 0x8b) return InputFormat::Gzip;
+    if ((unsigned char)head[1] == 0x9d) return InputFormat::Compress;
+  }
+  // the first header record of a Compact RINEX file
+  std::string_view first = head.substr(0, head.find('\n'));
+  if (first.find("COMPACT RINEX FORMAT") != std::string_view::npos) return InputFormat::Hatanaka;
+  return InputFormat::Plain;
+}
+
+// read up to n bytes from src into a string, for sniffing its format
+static std::string read_head(ByteSource& src, size_t n) {
+  std::string head(n, '\0');
+  size_t got = 0;
+  while (got < n) {
+    size_t k = src.read(&head[got], n - got);
+    if (k == 0) break;
+    got += k;
+  }
+  head.resize(got);
+  return head;
+}
+
+std::unique_ptr<ByteSource> open_rinex_text_source(const std::string& path, bool threaded,
+                                                   AsyncReader* io) {
+  std::unique_ptr<ByteSource> src;
+  if (io) {
+    src = io->open(path);
+    if (!src) return nullptr;
+  } else {
+    auto file = std::make_unique<FileSource>(path);
+    if (!file->is_open()) return nullptr;
+    src = std::move(file);
+  }
+  bool decoded = false;
+
+  // peel off the compression layer, then look for Compact RINEX underneath
+  for (int layer = 0; layer < 2; ++layer) {
+    std::string head = read_head(*src, 256);
+    InputFormat fmt = detect_input_format(head);
+    src = std::make_unique<PrefixedSource>(std::move(head), std::move(src));
+    if (fmt == InputFormat::Gzip) {
+      src = std::make_unique<GzipSource>(std::move(src));
+    } else if (fmt == InputFormat::Compress) {
+      src = std::make_unique<LzwSource>(std::move(src));
+    } else if (fmt == InputFormat::Hatanaka) {
+      src = std::make_unique<CrxSource>(std::move(src));
+      decoded = true;
+      break;
+    } else {
+      break;
+    }
+    decoded = true;
+  }
+  if (threaded && (decoded || !io)) src = std::make_unique<ThreadedSource>(std::move(src));
+  return src;
+}
+
+} // end namespace rinex
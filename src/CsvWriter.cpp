@@ -0,0 +1,244 @@
+// File:   CsvWriter.cpp
+// Description:
+// Export parsed RINEX observations as CSV, formatted in parallel blocks.
+//
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include "../include/CsvWriter.hpp"
+#include "../include/ObsFlags.hpp"
+#include "../include/ThreadPool.hpp"
+
+namespace rinex {
+
+// longest value field: a double in shortest form, e.g. "-1.7976931348623157e+308"
+static constexpr size_t kMaxValueChars = 24;
+// longest time field: "yyyy-mm-dd hh:mm:ss.sssssssss"
+static constexpr size_t kMaxTimeChars = 29;
+// values below this many units are written from integer thousandths
+static constexpr double kMaxFixedValue = 1e15;
+
+// v as exactly n decimal digits
+static char* put_digits(char* p, uint64_t v, int n) {
+  for (int i = n - 1; i >= 0; --i) {
+    p[i] = (char)('0' + v % 10);
+    v /= 10;
+  }
+  return p + n;
+}
+
+static char* put_time(char* p, int64_t ns) {
+  int64_t days = floor_div(ns, kNsPerDay);
+  int64_t rem = ns - days * kNsPerDay;
+  int year, month, day;
+  civil_from_days(days + kGpsEpochDays, year, month, day);
+  int64_t sec = rem / kNsPerSecond, frac = rem % kNsPerSecond;
+  p = put_digits(p, (uint64_t)year, 4);
+  *p++ = '-';
+  p = put_digits(p, (uint64_t)month, 2);
+  *p++ = '-';
+  p = put_digits(p, (uint64_t)day, 2);
+  *p++ = ' ';
+  p = put_digits(p, (uint64_t)(sec / 3600), 2);
+  *p++ = ':';
+  p = put_digits(p, (uint64_t)(sec / 60 % 60), 2);
+  *p++ = ':';
+  p = put_digits(p, (uint64_t)(sec % 60), 2);
+  *p++ = '.';
+  if (frac % 100 == 0) return put_digits(p, (uint64_t)(frac / 100), 7);
+  return put_digits(p, (uint64_t)frac, 9);
+}
+
+// v thousandths as [-]digits.ddd
+static char* put_thousandths(char* p, int64_t v) {
+  uint64_t u = (uint64_t)v;
+  if (v < 0) {
+    *p++ = '-';
+    u = 0 - u;
+  }
+  p = std::to_chars(p, p + 20, u / 1000).ptr;
+  *p++ = '.';
+  return put_digits(p, u % 1000, 3);
+}
+
+static char* put_value(char* p, double v) {
+  if (v == 0.0) return p;
+  if (std::fabs(v) < kMaxFixedValue) return put_thousandths(p, to_fixed_point(v));
+  return std::to_chars(p, p + kMaxValueChars, v).ptr; // out of F14.3 range, or NaN
+}
+
+static char* put_value(char* p, int64_t v) {
+  return v == 0 ? p : put_thousandths(p, v);
+}
+
+// what to write and how, shared by the formatting tasks
+struct CsvFormat {
+  const RinexObs& obs;
+  std::vector<size_t> types;               // columns of obs to write, in order
+  std::vector<uint8_t> keep;               // per satellite table entry
+  std::vector<std::array<char, 3>> names;  // per satellite table entry, e.g. "G05"
+  char delim = ',';
+  bool flags = false;
+  size_t row_chars = 0; // upper bound of one line
+
+  CsvFormat(const RinexObs& o, const CsvOptions& opts)
+      : obs(o), delim(opts.delimiter), flags(opts.flags) {
+    if (opts.obs_codes.empty()) {
+      for (size_t t = 0; t < obs.obs_types.size(); ++t) types.push_back(t);
+    } else {
+      for (const std::string& code : opts.obs_codes) {
+        int t = obs.obs_type_index(code);
+        if (t >= 0) types.push_back((size_t)t);
+      }
+    }
+    keep.assign(obs.sats.size(), opts.sats.empty() ? 1 : 0);
+    for (SatId sv : opts.sats) {
+      int i = obs.sat_index(sv);
+      if (i >= 0) keep[(size_t)i] = 1;
+    }
+    names.resize(obs.sats.size());
+    for (size_t i = 0; i < obs.sats.size(); ++i) {
+      names[i][0] = obs.sats[i].letter();
+      put_digits(&names[i][1], (uint64_t)obs.sats[i].prn(), 2);
+    }
+    // value and delimiter, then ",l,s" with up to two digits each
+    row_chars = kMaxTimeChars + 1 + 3 + 1 + types.size() * (kMaxValueChars + 1 + (flags ? 6 : 0));
+  }
+
+  std::string header() const {
+    std::string h = "time";
+    h += delim;
+    h += "sat";
+    for (size_t t : types) {
+      h += delim;
+      h += obs.obs_types[t];
+      if (flags) {
+        h += delim;
+        h += obs.obs_types[t] + "_lli";
+        h += delim;
+        h += obs.obs_types[t] + "_ssi";
+      }
+    }
+    h += '\n';
+    return h;
+  }
+
+  // lines of epochs [e0, e1) into text (grown as needed, never shrunk); returns their length
+  size_t format(size_t e0, size_t e1, std::vector<char>& text) const {
+    if (e0 == e1) return 0;
+    size_t rows = obs.rows_end(e1 - 1) - obs.rows_begin(e0);
+    if (text.size() < rows * row_chars) text.resize(rows * row_chars);
+    char* p = text.data();
+    char time[kMaxTimeChars];
+    for (size_t e = e0; e < e1; ++e) {
+      size_t time_len = (size_t)(put_time(time, obs.epoch_time[e]) - time);
+      for (size_t r = obs.rows_begin(e); r < obs.rows_end(e); ++r) {
+        size_t sat = obs.row_sat[r];
+        if (!keep[sat]) continue;
+        std::copy(time, time + time_len, p);
+        p += time_len;
+        *p++ = delim;
+        p = std::copy(names[sat].begin(), names[sat].end(), p);
+        for (size_t t : types) {
+          *p++ = delim;
+          p = obs.fixed_point ? put_value(p, obs.obs_fixed[t][r]) : put_value(p, obs.obs[t][r]);
+          if (flags) {
+            uint8_t f = obs.flags[t][r];
+            *p++ = delim;
+            p = std::to_chars(p, p + 2, obs_lli(f)).ptr;
+            *p++ = delim;
+            p = std::to_chars(p, p + 2, obs_ssi(f)).ptr;
+          }
+        }
+        *p++ = '\n';
+      }
+    }
+    return (size_t)(p - text.data());
+  }
+};
+
+// a block being formatted, and the buffer it is formatted into
+struct CsvSlot {
+  std::vector<char> text;
+  size_t used = 0;
+  ThreadPool::TaskGroup group;
+};
+
+bool write_obs_csv(std::ostream& out, const RinexObs& obs, const CsvOptions& opts) {
+  CsvFormat fmt(obs, opts);
+  std::string header = fmt.header();
+  out.write(header.data(), (std::streamsize)header.size());
+
+  // cut the epochs into blocks of about block_bytes of text
+  size_t rows_per_block = std::max<size_t>(1, opts.block_bytes / fmt.row_chars);
+  std::vector<size_t> bounds{0};
+  for (size_t e = 0, rows = 0; e < obs.num_epochs(); ++e) {
+    rows += obs.rows_end(e) - obs.rows_begin(e);
+    if (rows >= rows_per_block || e + 1 == obs.num_epochs()) {
+      bounds.push_back(e + 1);
+      rows = 0;
+    }
+  }
+  size_t nblocks = bounds.size() - 1;
+
+  size_t threads = opts.pool ? opts.pool->size()
+                             : (opts.threads ? opts.threads : std::thread::hardware_concurrency());
+  if (threads <= 1 || nblocks <= 1) {
+    std::vector<char> text;
+    for (size_t b = 0; b < nblocks && out; ++b) {
+      size_t n = fmt.format(bounds[b], bounds[b + 1], text);
+      out.write(text.data(), (std::streamsize)n);
+    }
+    return (bool)out;
+  }
+
+  // the calling thread takes part in wait(), so a pool of our own needs one less
+  std::unique_ptr<ThreadPool> own_pool;
+  ThreadPool* pool = opts.pool;
+  if (!pool) {
+    own_pool.reset(new ThreadPool((unsigned)(threads - 1)));
+    pool = own_pool.get();
+  }
+
+  // Up to two blocks per thread are formatted ahead of the one being written. Block b
+  // goes to slot b % window, whose buffer it reuses once block b - window is written.
+  size_t window = std::min(nblocks, 2 * threads);
+  std::unique_ptr<CsvSlot[]> slots(new CsvSlot[window]);
+  auto submit = [&](size_t b) {
+    CsvSlot& slot = slots[b % window];
+    pool->submit(slot.group, [&fmt, &bounds, &slot, b]() {
+      slot.used = fmt.format(bounds[b], bounds[b + 1], slot.text);
+    });
+  };
+  for (size_t b = 0; b < window; ++b) submit(b);
+  for (size_t b = 0; b < nblocks; ++b) {
+    CsvSlot& slot = slots[b % window];
+    pool->wait(slot.group);
+    if (!out) continue; // let the submitted blocks finish, but stop writing
+    out.write(slot.text.data(), (std::streamsize)slot.used);
+    if (b + window < nblocks) submit(b + window);
+  }
+  return (bool)out;
+}
+
+bool write_obs_csv(const std::string& path, const RinexObs& obs, const CsvOptions& opts) {
+  std::string tmp = path + ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  if (!f) return false;
+  bool ok = write_obs_csv(f, obs, opts);
+  f.close();
+  if (!ok || !f || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // end namespace rinex
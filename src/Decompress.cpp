@@ -0,0 +1,219 @@
+// File:   Decompress.cpp
+// Description:
+// Streaming gzip and Unix compress (.Z) decoders.
+//
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef RINEX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "../include/Decompress.hpp"
+
+namespace rinex {
+
+// size of the compressed input buffers
+static constexpr size_t kInChunk = 1 << 16;
+
+// ---------------------------------------------------------------------------
+// gzip
+
+#ifdef RINEX_HAVE_ZLIB
+
+GzipSource::GzipSource(std::unique_ptr<ByteSource> src) : src_(std::move(src)), in_(kInChunk) {
+  z_stream* zs = new z_stream();
+  // 15 + 32: 32K window, accept both gzip and zlib headers
+  if (inflateInit2(zs, 15 + 32) != Z_OK) {
+    delete zs;
+    failed_ = true;
+    return;
+  }
+  zs_ = zs;
+}
+
+GzipSource::~GzipSource() {
+  if (zs_) {
+    inflateEnd(static_cast<z_stream*>(zs_));
+    delete static_cast<z_stream*>(zs_);
+  }
+}
+
+size_t GzipSource::read(char* buf, size_t n) {
+  if (!zs_ || failed_) return 0;
+  z_stream* zs = static_cast<z_stream*>(zs_);
+  zs->next_out = reinterpret_cast<Bytef*>(buf);
+  zs->avail_out = (uInt)std::min<size_t>(n, 1u << 30);
+  while (zs->avail_out > 0) {
+    if (zs->avail_in == 0) {
+      if (eof_) break;
+      size_t k = src_->read(in_.data(), in_.size());
+      if (k == 0) {
+        eof_ = true;
+        failed_ = src_->failed();
+        break;
+      }
+      zs->next_in = reinterpret_cast<Bytef*>(in_.data());
+      zs->avail_in = (uInt)k;
+    }
+    int rc = inflate(zs, Z_NO_FLUSH);
+    if (rc == Z_STREAM_END) {
+      // gzip files may hold several members back to back
+      inflateReset(zs);
+    } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+      failed_ = true;
+      break;
+    }
+  }
+  return n - zs->avail_out;
+}
+
+#else
+
+GzipSource::GzipSource(std::unique_ptr<ByteSource> src) : src_(std::move(src)), failed_(true) {}
+GzipSource::~GzipSource() = default;
+size_t GzipSource::read(char*, size_t) { return 0; }
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Unix compress. Codes are written LSB first in groups of eight; when the code width
+// grows or the table is cleared the rest of the current group is padding.
+
+static constexpr uint32_t kLzwClear = 256;
+static constexpr uint32_t kLzwFirst = 257;
+
+bool LzwSource::read_header() {
+  unsigned char hdr[3];
+  size_t got = 0;
+  while (got < 3) {
+    size_t k = src_->read(reinterpret_cast<char*>(hdr) + got, 3 - got);
+    if (k == 0) return false;
+    got += k;
+  }
+  if (hdr[0] != 0x1f || hdr[1] != 0x9d) return false;
+  maxbits_ = hdr[2] & 0x1f;
+  block_mode_ = (hdr[2] & 0x80) != 0;
+  if (maxbits_ < 9 || maxbits_ > 16) return false;
+  prefix_.assign(1u << maxbits_, 0);
+  suffix_.assign(1u << maxbits_, 0);
+  for (uint32_t c = 0; c < 256; ++c) suffix_[c] = (uint8_t)c;
+  n_bits_ = 9;
+  maxcode_ = (1u << n_bits_) - 1;
+  free_ent_ = block_mode_ ? kLzwFirst : 256;
+  return true;
+}
+
+// make sure the input buffer covers [bitpos_, bitpos_ + need_bits); false at end of input
+bool LzwSource::fill_input(size_t need_bits) {
+  while (in_base_bits_ + in_.size() * 8 < bitpos_ + need_bits) {
+    if (in_eof_) return false;
+    // drop whole bytes that are behind the read position
+    size_t drop = (size_t)((bitpos_ - in_base_bits_) / 8);
+    drop = std::min(drop, in_.size());
+    in_.erase(in_.begin(), in_.begin() + drop);
+    in_base_bits_ += drop * 8;
+    size_t old = in_.size();
+    in_.resize(old + kInChunk);
+    size_t k = src_->read(reinterpret_cast<char*>(in_.data()) + old, kInChunk);
+    in_.resize(old + k);
+    if (k == 0) {
+      in_eof_ = true;
+      if (src_->failed()) failed_ = true;
+    }
+  }
+  return true;
+}
+
+// decode codes into out_ until it holds some bytes or the stream ends
+bool LzwSource::decode_some() {
+  const uint32_t maxmaxcode = 1u << maxbits_;
+  while (out_.size() - out_pos_ < kInChunk) {
+    if (free_ent_ > maxcode_ && n_bits_ < maxbits_) {
+      // skip to the end of the current group and widen the codes
+      uint64_t group = (uint64_t)n_bits_ * 8;
+      bitpos_ = group_bits_ + (bitpos_ - group_bits_ + group - 1) / group * group;
+      group_bits_ = bitpos_;
+      ++n_bits_;
+      maxcode_ = (n_bits_ == maxbits_) ? maxmaxcode : (1u << n_bits_) - 1;
+    }
+    if (!fill_input((size_t)n_bits_)) return false;
+
+    size_t off = (size_t)(bitpos_ - in_base_bits_);
+    size_t byte = off / 8;
+    uint32_t word = in_[byte];
+    if (byte + 1 < in_.size()) word |= (uint32_t)in_[byte + 1] << 8;
+    if (byte + 2 < in_.size()) word |= (uint32_t)in_[byte + 2] << 16;
+    uint32_t code = (word >> (off % 8)) & ((1u << n_bits_) - 1);
+    bitpos_ += (uint64_t)n_bits_;
+
+    if (oldcode_ == -1) {
+      if (code >= 256) {
+        failed_ = true;
+        return false;
+      }
+      finchar_ = (uint8_t)code;
+      oldcode_ = (int32_t)code;
+      out_.push_back((char)code);
+      continue;
+    }
+    if (code == kLzwClear && block_mode_) {
+      uint64_t group = (uint64_t)n_bits_ * 8;
+      bitpos_ = group_bits_ + (bitpos_ - group_bits_ + group - 1) / group * group;
+      group_bits_ = bitpos_;
+      free_ent_ = kLzwFirst - 1;
+      n_bits_ = 9;
+      maxcode_ = (1u << n_bits_) - 1;
+      continue;
+    }
+
+    uint32_t incode = code;
+    stack_.clear();
+    if (code >= free_ent_) { // KwKwK case
+      if (code > free_ent_) {
+        failed_ = true;
+        return false;
+      }
+      stack_.push_back(finchar_);
+      code = (uint32_t)oldcode_;
+    }
+    while (code >= 256) {
+      stack_.push_back(suffix_[code]);
+      code = prefix_[code];
+    }
+    finchar_ = suffix_[code];
+    stack_.push_back(finchar_);
+    out_.insert(out_.end(), stack_.rbegin(), stack_.rend());
+
+    if (free_ent_ < maxmaxcode) {
+      prefix_[free_ent_] = (uint16_t)oldcode_;
+      suffix_[free_ent_] = finchar_;
+      ++free_ent_;
+    }
+    oldcode_ = (int32_t)incode;
+  }
+  return true;
+}
+
+size_t LzwSource::read(char* buf, size_t n) {
+  if (failed_) return 0;
+  if (!started_) {
+    started_ = true;
+    if (!read_header()) {
+      failed_ = true;
+      return 0;
+    }
+  }
+  if (out_pos_ == out_.size()) {
+    out_.clear();
+    out_pos_ = 0;
+    if (!done_ && !decode_some()) done_ = true;
+  }
+  size_t k = std::min(n, out_.size() - out_pos_);
+  memcpy(buf, out_.data() + out_pos_, k);
+  out_pos_ += k;
+  return k;
+}
+
+} // end namespace rinex
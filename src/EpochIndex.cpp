@@ -0,0 +1,177 @@
+// File:   EpochIndex.cpp
+// Description:
+// Epoch time index of plain RINEX observation files, its sidecar file and
+// time-window reads through it.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "../include/ByteSource.hpp"
+#include "../include/EpochIndex.hpp"
+#include "../include/EpochReader.hpp"
+#include "../include/FieldDecoder.hpp"
+
+namespace rinex {
+
+static constexpr char kIndexMagic[8] = {'R', 'N', 'X', 'E', 'I', 'D', 'X', '1'};
+static constexpr uint32_t kIndexVersion = 1;
+
+struct IndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t count;
+};
+
+ParseRinexError EpochIndex::build(const std::string& path) {
+  entries_.clear();
+  MappedFile file;
+  if (!file.open(path)) return ParseRinexError::FileNotFound;
+  if (detect_input_format(file.view().substr(0, 256)) != InputFormat::Plain) {
+    return ParseRinexError::UnsupportedFormat; // offsets into decoded text cannot be seeked to
+  }
+  if (!file_stamp(path, source_size_, source_mtime_)) source_size_ = file.size();
+
+  LineScanner scanner(file.view());
+  RinexHeader hdr;
+  ParseRinexError err = parse_rinex_header(scanner, hdr);
+  if (err != ParseRinexError::Success) return err;
+
+  // only epoch records are decoded; every other line is passed over
+  std::string_view line;
+  ObsEpoch ep;
+  while (true) {
+    size_t start = scanner.offset();
+    if (!scanner.next(line)) break;
+    bool is_epoch = hdr.is_v3 ? !line.empty() && line[0] == '>' && decode_epoch_v3(line, ep)
+                              : decode_epoch_v2(line, ep);
+    if (!is_epoch) continue;
+    if (ep.event_flag >= 2 && ep.event_flag <= 5) {
+      // header records follow instead of satellites
+      for (int i = 0; i < ep.num_sv && scanner.next(line); ++i) {}
+      continue;
+    }
+    entries_.push_back(EpochIndexEntry{start, ep.time});
+  }
+  return entries_.empty() ? ParseRinexError::NoEpochs : ParseRinexError::Success;
+}
+
+bool EpochIndex::save(const std::string& index_path) const {
+  IndexHeader hdr = {};
+  memcpy(hdr.magic, kIndexMagic, sizeof(kIndexMagic));
+  hdr.version = kIndexVersion;
+  hdr.source_size = source_size_;
+  hdr.source_mtime = source_mtime_;
+  hdr.count = entries_.size();
+
+  std::string tmp = index_path + ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  if (!f) return false;
+  f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  f.write(reinterpret_cast<const char*>(entries_.data()),
+          (std::streamsize)(entries_.size() * sizeof(EpochIndexEntry)));
+  f.close();
+  if (!f || std::rename(tmp.c_str(), index_path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+ParseRinexError EpochIndex::load(const std::string& index_path) {
+  entries_.clear();
+  MappedFile file;
+  if (!file.open(index_path)) return ParseRinexError::FileNotFound;
+  IndexHeader hdr;
+  if (file.size() < sizeof(hdr)) return ParseRinexError::InvalidCache;
+  memcpy(&hdr, file.data(), sizeof(hdr));
+  if (memcmp(hdr.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || hdr.version != kIndexVersion ||
+      (file.size() - sizeof(hdr)) / sizeof(EpochIndexEntry) != hdr.count) {
+    return ParseRinexError::InvalidCache;
+  }
+  entries_.resize(hdr.count);
+  memcpy(entries_.data(), file.data() + sizeof(hdr), hdr.count * sizeof(EpochIndexEntry));
+  source_size_ = hdr.source_size;
+  source_mtime_ = hdr.source_mtime;
+  return ParseRinexError::Success;
+}
+
+ParseRinexError EpochIndex::open(const std::string& path, const std::string& index_path) {
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  if (!file_stamp(path, size, mtime)) return ParseRinexError::FileNotFound;
+  if (load(index_path) == ParseRinexError::Success && source_size_ == size && source_mtime_ == mtime) {
+    return ParseRinexError::Success;
+  }
+  ParseRinexError err = build(path);
+  if (err != ParseRinexError::Success) return err;
+  save(index_path);
+  return ParseRinexError::Success;
+}
+
+std::pair<size_t, size_t> EpochIndex::range(int64_t t0, int64_t t1) const {
+  auto by_time = [](const EpochIndexEntry& e, int64_t t) { return e.time < t; };
+  size_t first = std::lower_bound(entries_.begin(), entries_.end(), t0, by_time) - entries_.begin();
+  size_t last = std::lower_bound(entries_.begin() + first, entries_.end(), t1, by_time) - entries_.begin();
+  return std::make_pair(first, std::max(first, last));
+}
+
+static ParseRinexError read_range(const std::string& path, const EpochIndex& index, int64_t t0,
+                                  int64_t t1, RinexObs& out, const ParseOptions& opts) {
+  MappedFile file;
+  if (!file.open(path)) return ParseRinexError::FileNotFound;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  file_stamp(path, size, mtime);
+  if (size != index.source_size() || mtime != index.source_mtime()) return ParseRinexError::InvalidCache;
+
+  LineScanner scanner(file.view());
+  RinexHeader hdr;
+  ParseRinexError err = parse_rinex_header(scanner, hdr, opts.stats);
+  if (err == ParseRinexError::Success && !opts.obs_codes.empty()) {
+    err = select_obs_types(hdr, opts.obs_codes);
+  }
+  if (err != ParseRinexError::Success) return err;
+  hdr.fixed_point = opts.fixed_point;
+  static_cast<RinexHeader&>(out) = hdr;
+  out.reset_columns();
+
+  // decode only the bytes between the first epoch in the window and the first after it
+  std::pair<size_t, size_t> r = index.range(t0, t1);
+  if (r.first == r.second) return ParseRinexError::NoEpochs;
+  size_t begin = index[r.first].offset;
+  size_t end = r.second < index.size() ? index[r.second].offset : file.size();
+  if (begin > end || end > file.size()) return ParseRinexError::InvalidCache;
+
+  if (opts.stats) {
+    opts.stats->bytes += scanner.offset() + (end - begin);
+    opts.stats->text_bytes += scanner.offset() + (end - begin);
+  }
+
+  EpochReader reader;
+  reader.open(file.view().substr(begin, end - begin), hdr);
+  reader.set_stats(opts.stats);
+  ObsEpoch ep;
+  while (reader.next(ep)) {
+    if (ep.time >= t0 && ep.time < t1) out.append(ep);
+  }
+  if (out.num_epochs() == 0) return ParseRinexError::NoEpochs;
+  return ParseRinexError::Success;
+}
+
+ParseRinexError read_rinex_range(const std::string& path, const EpochIndex& index, int64_t t0,
+                                 int64_t t1, RinexObs& out, const ParseOptions& opts) {
+  if (!opts.stats) return read_range(path, index, t0, t1, out, opts);
+  int64_t start = stats_clock_ns();
+  ParseRinexError err = read_range(path, index, t0, t1, out, opts);
+  ++opts.stats->files;
+  opts.stats->total_ns += stats_clock_ns() - start;
+  return err;
+}
+
+} // end namespace rinex
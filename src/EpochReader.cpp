@@ -0,0 +1,301 @@
+// File:   EpochReader.cpp
+// Description:
+// Streaming decoder for the observation records of a RINEX file.
+//
+
+#include <algorithm>
+
+#include "../include/EpochReader.hpp"
+#include "../include/FieldDecoder.hpp"
+
+namespace rinex {
+
+// true for lines that hold nothing but blanks
+static bool is_blank(std::string_view line) {
+  return line.find_first_not_of(" \t") == std::string_view::npos;
+}
+
+// event flags 2-5 are followed by num_sv header records instead of satellites
+static bool is_special_event(int event_flag) {
+  return event_flag >= 2 && event_flag <= 5;
+}
+
+// append an empty row for sv to ep and return the offset of its values
+static size_t add_sat_row(SatId sv, ObsEpoch& ep) {
+  ep.sats.push_back(sv);
+  size_t base = ep.flags.size();
+  // blank observations stay 0
+  if (ep.fixed_point) ep.obs_fixed.resize(base + ep.num_obs, 0);
+  else ep.obs.resize(base + ep.num_obs, 0.0);
+  ep.flags.resize(base + ep.num_obs, 0);
+  return base;
+}
+
+// decode n slots of line into the row at base, in the storage of ep
+static void decode_row_slots(std::string_view line, size_t first_col, size_t slot_base,
+                             const ObsSlot* slots, size_t n, size_t base, ObsEpoch& ep) {
+  if (ep.fixed_point) {
+    decode_obs_slots(line, first_col, slot_base, slots, n, ep.obs_fixed.data() + base, ep.flags.data() + base);
+  } else {
+    decode_obs_slots(line, first_col, slot_base, slots, n, ep.obs.data() + base, ep.flags.data() + base);
+  }
+}
+
+// Append a satellite and its selected observation slots (values and LLI/SSI) to ep,
+// using the slot layout of the satellite's system. Unselected slots are never looked
+// at. A satellite whose system has no selected slots is dropped.
+static void decode_obs_line(SatId sv, std::string_view line, size_t first_col,
+                            const std::vector<ObsSlot>& slots, ObsEpoch& ep) {
+  if (slots.empty()) return;
+  size_t base = add_sat_row(sv, ep);
+  decode_row_slots(line, first_col, 0, slots.data(), slots.size(), base, ep);
+}
+
+ParseRinexError EpochReader::open(const std::string& path, bool io_thread, AsyncReader* io) {
+  source_.reset();
+  file_.close();
+  if (!io_thread && !io) {
+    if (!file_.open(path)) return ParseRinexError::FileNotFound;
+    if (detect_input_format(file_.view().substr(0, 256)) == InputFormat::Plain) {
+      scanner_ = LineScanner(file_.view());
+      return parse_rinex_header(scanner_, header_, stats_);
+    }
+    file_.close();
+  }
+
+  // compressed, compacted or read ahead: stream the text, which is sniffed on the way,
+  // instead of mapping the file
+  source_ = open_rinex_text_source(path, true, io);
+  if (!source_) return ParseRinexError::FileNotFound;
+  scanner_ = LineScanner(source_.get());
+  ParseRinexError err = parse_rinex_header(scanner_, header_, stats_);
+  if (err != ParseRinexError::Success && source_->failed()) return ParseRinexError::DecompressionFailed;
+  return err;
+}
+
+void EpochReader::open(std::string_view body, const RinexHeader& hdr) {
+  file_.close();
+  source_.reset();
+  scanner_ = LineScanner(body);
+  header_ = hdr;
+}
+
+ParseRinexError EpochReader::select_obs_types(const std::vector<std::string>& codes) {
+  return rinex::select_obs_types(header_, codes);
+}
+
+size_t EpochReader::v2_lines_per_sat() const {
+  // every system shares the one RINEX 2 table
+  size_t types = header_.sys_obs_types[0].size();
+  return std::max<size_t>(1, (types + kV2ObsPerLine - 1) / kV2ObsPerLine);
+}
+
+bool EpochReader::next(ObsEpoch& ep) {
+  ep.num_obs = header_.obs_types.size();
+  ep.fixed_point = header_.fixed_point;
+  if (!stats_) return header_.is_v3 ? next_v3<false>(ep) : next_v2<false>(ep);
+
+  size_t obs_capacity = ep.flags.capacity(), sats_capacity = ep.sats.capacity();
+  bool ok = header_.is_v3 ? next_v3<true>(ep) : next_v2<true>(ep);
+  stats_->allocations += (ep.flags.capacity() != obs_capacity ? 2 : 0) + (ep.sats.capacity() != sats_capacity);
+  return ok;
+}
+
+template <bool kStats>
+bool EpochReader::next_line(std::string_view& line) {
+  if (!scanner_.next(line)) return false;
+  if constexpr (kStats) ++stats_->lines;
+  return true;
+}
+
+template <bool kStats>
+void EpochReader::unread_line(size_t mark) {
+  scanner_.seek(mark);
+  if constexpr (kStats) --stats_->lines;
+}
+
+template <bool kStats>
+void EpochReader::skip_event(const ObsEpoch& ep) {
+  std::string_view line;
+  int n = 0;
+  while (n < ep.num_sv && next_line<kStats>(line)) ++n;
+  if constexpr (kStats) stats_->event_records += 1 + n;
+}
+
+// count a decoded satellite record of system sys and its slots
+template <bool kStats>
+void EpochReader::count_sat(GnssSystem sys) {
+  if constexpr (kStats) {
+    size_t slots = header_.slots(sys).size();
+    if (slots == 0) ++stats_->skipped_satellites;
+    else ++stats_->satellites;
+    stats_->fields_decoded += slots;
+    stats_->fields_skipped += header_.sys_obs_types[(size_t)sys].size() - slots;
+  }
+}
+
+// add the time since t to the stage timer and move t to now
+static void lap(int64_t& stage_ns, int64_t& t) {
+  int64_t now = stats_clock_ns();
+  stage_ns += now - t;
+  t = now;
+}
+
+template <bool kStats>
+bool EpochReader::next_v3(ObsEpoch& ep) {
+  int64_t t = kStats ? stats_clock_ns() : 0;
+  std::string_view line;
+  while (next_line<kStats>(line)) {
+    // only epoch records start an epoch; stray lines are skipped
+    if (line.empty() || line[0] != '>' || !decode_epoch_v3(line, ep)) {
+      if constexpr (kStats) ++stats_->stray_lines;
+      continue;
+    }
+    if (is_special_event(ep.event_flag)) {
+      skip_event<kStats>(ep);
+      continue;
+    }
+    if constexpr (kStats) lap(stats_->epoch_ns, t);
+
+    ep.clear_sats();
+    int svs_remaining = ep.num_sv;
+    while (svs_remaining > 0) {
+      size_t mark = scanner_.offset();
+      if (!next_line<kStats>(line)) { // truncated final epoch
+        if constexpr (kStats) {
+          ++stats_->dropped_epochs;
+          lap(stats_->obs_ns, t);
+        }
+        return false;
+      }
+      if (is_blank(line)) {
+        if constexpr (kStats) ++stats_->stray_lines;
+        continue;
+      }
+      if (line[0] == '>') { // next epoch began early; drop this one
+        unread_line<kStats>(mark);
+        break;
+      }
+      // the sv id occupies columns 0-2 and selects the slot layout
+      SatId sv = SatId::parse(line.substr(0, 3));
+      decode_obs_line(sv, line, kV3FirstObsCol, header_.slots(sv.system()), ep);
+      count_sat<kStats>(sv.system());
+      svs_remaining--;
+    }
+    if constexpr (kStats) {
+      lap(stats_->obs_ns, t);
+      ++(svs_remaining == 0 ? stats_->epochs : stats_->dropped_epochs);
+    }
+    if (svs_remaining == 0) return true;
+  }
+  if constexpr (kStats) lap(stats_->epoch_ns, t);
+  return false;
+}
+
+template <bool kStats>
+bool EpochReader::next_v2(ObsEpoch& ep) {
+  int64_t t = kStats ? stats_clock_ns() : 0;
+  std::string_view line;
+  while (next_line<kStats>(line)) {
+    if (!decode_epoch_v2(line, ep)) {
+      if constexpr (kStats) ++stats_->stray_lines;
+      continue;
+    }
+    if (is_special_event(ep.event_flag)) {
+      skip_event<kStats>(ep);
+      continue;
+    }
+
+    // the satellite list is read by column (12 per line, continued on the
+    // following lines)
+    sv_ids_.clear();
+    while (true) {
+      for (size_t k = 0; k < kV2SatsPerLine && (int)sv_ids_.size() < ep.num_sv; ++k) {
+        size_t col = kV2SatListCol + 3 * k;
+        sv_ids_.push_back(col < line.size() ? SatId::parse(line.substr(col, 3)) : SatId());
+      }
+      if ((int)sv_ids_.size() >= ep.num_sv || !next_line<kStats>(line)) break;
+    }
+    if constexpr (kStats) lap(stats_->epoch_ns, t);
+    if ((int)sv_ids_.size() < ep.num_sv) { // truncated final epoch
+      if constexpr (kStats) ++stats_->dropped_epochs;
+      return false;
+    }
+
+    // Each satellite takes lines_per_sat lines of five slots. The lines are decoded as
+    // they are read (a streamed line does not outlive the next one), walking the
+    // satellite's slots, which are in record order. Blank lines are records whose
+    // slots are all blank and are counted like any other.
+    ep.clear_sats();
+    size_t lines_per_sat = v2_lines_per_sat();
+    ObsEpoch probe;
+    bool early = false;
+    size_t k = 0;
+    for (; k < sv_ids_.size() && !early; ++k) {
+      const std::vector<ObsSlot>& slots = header_.slots(sv_ids_[k].system());
+      size_t base = slots.empty() ? 0 : add_sat_row(sv_ids_[k], ep);
+      size_t next_slot = 0;
+      for (size_t l = 0; l < lines_per_sat; ++l) {
+        size_t mark = scanner_.offset();
+        if (!next_line<kStats>(line)) { // truncated final epoch
+          if constexpr (kStats) {
+            ++stats_->dropped_epochs;
+            lap(stats_->obs_ns, t);
+          }
+          return false;
+        }
+        if (decode_epoch_v2(line, probe)) { // next epoch began early; drop this one
+          unread_line<kStats>(mark);
+          early = true;
+          break;
+        }
+        size_t first = next_slot, line_end = (l + 1) * kV2ObsPerLine;
+        while (next_slot < slots.size() && slots[next_slot].slot < line_end) ++next_slot;
+        decode_row_slots(line, 0, l * kV2ObsPerLine, slots.data() + first, next_slot - first, base, ep);
+      }
+      if (!early) count_sat<kStats>(sv_ids_[k].system());
+    }
+    if constexpr (kStats) {
+      lap(stats_->obs_ns, t);
+      ++(early ? stats_->dropped_epochs : stats_->epochs);
+    }
+    if (!early) return true;
+  }
+  if constexpr (kStats) lap(stats_->epoch_ns, t);
+  return false;
+}
+
+size_t find_epoch_start(std::string_view body, size_t pos, bool is_v3) {
+  // move to the start of the next line unless pos already is one
+  if (pos > 0 && pos < body.size() && body[pos - 1] != '\n') {
+    const char* nl = find_newline(body.data() + pos, body.data() + body.size());
+    if (nl == body.data() + body.size()) return body.size();
+    pos = (size_t)(nl - body.data()) + 1;
+  }
+  LineScanner scanner(body);
+  scanner.seek(pos);
+  std::string_view line;
+  ObsEpoch probe;
+  while (true) {
+    size_t start = scanner.offset();
+    if (!scanner.next(line)) return body.size();
+    // RINEX 3 epoch records are marked by '>'; RINEX 2 records have to be decoded,
+    // but satellite-list continuations and observation lines never decode as one
+    if (is_v3 ? (!line.empty() && line[0] == '>') : decode_epoch_v2(line, probe)) return start;
+  }
+}
+
+ParseRinexError for_each_epoch(const std::string& path, RinexHeader& hdr,
+                               const std::function<bool(const ObsEpoch&)>& fn) {
+  EpochReader reader;
+  ParseRinexError err = reader.open(path);
+  if (err != ParseRinexError::Success) return err;
+  hdr = reader.header();
+  ObsEpoch ep;
+  while (reader.next(ep)) {
+    if (!fn(ep)) break;
+  }
+  return ParseRinexError::Success;
+}
+
+} // end namespace rinex
@@ -0,0 +1,279 @@
+// File:   FieldDecoder.cpp
+// Description:
+// Fixed-column decoding of RINEX epoch records.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../include/FieldDecoder.hpp"
+#include "../include/LineScan.hpp"
+
+#if !defined(RINEX_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RINEX_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace rinex {
+
+// the packed epoch time; the calendar fields are not kept
+static int64_t epoch_time_ns(int year, int month, int day, int hour, int minute, int64_t second_ns) {
+  return gps_time_from_day(year, month, day, ((int64_t)hour * 3600 + minute * 60) * kNsPerSecond + second_ns);
+}
+
+bool decode_epoch_v3(std::string_view line, ObsEpoch& ep) {
+  // columns: '>' 0, year 2-5, month 7-8, day 10-11, hour 13-14, minute 16-17,
+  // second 18-28 (F11.7), event flag 31, number of satellites 32-34
+  if (line.size() < 35 || line[0] != '>') return false;
+  int year, month, day, hour, minute, event_flag, num_sv;
+  int64_t second_ns;
+  if (!decode_int_field(line, 2, 4, year) ||
+      !decode_int_field(line, 7, 2, month) ||
+      !decode_int_field(line, 10, 2, day) ||
+      !decode_int_field(line, 13, 2, hour) ||
+      !decode_int_field(line, 16, 2, minute) ||
+      !decode_seconds_ns(line, 18, 11, second_ns) ||
+      !decode_int_field(line, 31, 1, event_flag) ||
+      !decode_int_field(line, 32, 3, num_sv)) return false;
+  ep.time = epoch_time_ns(year, month, day, hour, minute, second_ns);
+  ep.event_flag = event_flag;
+  ep.num_sv = num_sv;
+  return true;
+}
+
+bool decode_epoch_v2(std::string_view line, ObsEpoch& ep) {
+  // columns: year 1-2, month 4-5, day 7-8, hour 10-11, minute 13-14,
+  // second 15-25 (F11.7), event flag 28, number of satellites 29-31
+  if (line.size() < 32) return false;
+  if (line[0] != ' ' || line[3] != ' ' || line[6] != ' ' || line[9] != ' ' || line[12] != ' ') return false;
+  int year, month, day, hour, minute, event_flag = 0, num_sv;
+  int64_t second_ns;
+  if (!decode_int_field(line, 1, 2, year) ||
+      !decode_int_field(line, 4, 2, month) ||
+      !decode_int_field(line, 7, 2, day) ||
+      !decode_int_field(line, 10, 2, hour) ||
+      !decode_int_field(line, 13, 2, minute) ||
+      !decode_seconds_ns(line, 15, 11, second_ns) ||
+      !decode_int_field(line, 29, 3, num_sv)) return false;
+  decode_int_field(line, 28, 1, event_flag); // a blank flag means "OK" (0)
+  year = year < 80 ? year + 2000 : (year < 100 ? year + 1900 : year);
+  ep.time = epoch_time_ns(year, month, day, hour, minute, second_ns);
+  ep.event_flag = event_flag;
+  ep.num_sv = num_sv;
+  return true;
+}
+
+// Observation slots. A value written as F14.3 has its decimal point at byte 10 of the
+// slot, three digits after it and a right-aligned integer part with an optional '-'
+// in front. The kernels classify the bytes of a slot into bitmasks (bit i = byte i)
+// and, for values of that shape, add up the digits with fixed weights: with the point
+// read as a 0 digit, the bytes [0, 14) shifted up by two form four groups of four
+// digits whose values combine to the mantissa in thousandths. It has at most 13 digits,
+// so the double made from it is exact and the division by 1000 rounds correctly, as in
+// decode_fixed_field.
+constexpr uint32_t kF14Value = 0x3fff; // bytes 0-13
+constexpr uint32_t kF14Int = 0x03ff;   // integer part, bytes 0-9
+constexpr uint32_t kF14Point = 1u << 10;
+constexpr uint32_t kF14Frac = 0x3800;  // the three decimals, bytes 11-13
+constexpr uint32_t kF14Units = 1u << 9;
+
+enum F14Shape : uint8_t { kF14Blank, kF14Fixed, kF14Other };
+
+struct F14Field {
+  int64_t mantissa; // thousandths, without the sign; set for kF14Fixed only
+  F14Shape shape;
+  bool neg;
+};
+
+static F14Shape f14_shape(uint32_t digit, uint32_t space, uint32_t minus, uint32_t point) {
+  if ((space & kF14Value) == kF14Value) return kF14Blank;
+  uint32_t lead = space & kF14Int;  // leading blanks: a run of bits from bit 0
+  uint32_t rest = kF14Int & ~lead;
+  uint32_t sign = minus & kF14Int;  // at most the first byte after the blanks
+  bool fixed = (point & kF14Point) && (digit & kF14Frac) == kF14Frac && (lead & (lead + 1)) == 0 &&
+               ((digit | sign) & kF14Int) == rest && (sign == 0 || sign == (rest & (0u - rest))) &&
+               (digit & kF14Units);
+  return fixed ? kF14Fixed : kF14Other;
+}
+
+static void set_shape(F14Field& f, uint32_t digit, uint32_t space, uint32_t minus, uint32_t point) {
+  f.shape = f14_shape(digit, space, minus, point);
+  f.neg = (minus & kF14Int) != 0;
+}
+
+// Decode the slots starting at a and b (16 readable bytes each) into out[0] and out[1]
+using F14Pair = void (*)(const char* a, const char* b, F14Field* out);
+
+#ifndef RINEX_SCAN_X86
+
+static void f14_scalar(const char* p, F14Field& f) {
+  uint32_t digit = 0, space = 0, minus = 0, point = 0;
+  for (size_t i = 0; i < kObsValueWidth; ++i) {
+    char c = p[i];
+    digit |= (uint32_t)(c >= '0' && c <= '9') << i;
+    space |= (uint32_t)(c == ' ') << i;
+    minus |= (uint32_t)(c == '-') << i;
+    point |= (uint32_t)(c == '.') << i;
+  }
+  set_shape(f, digit, space, minus, point);
+  if (f.shape != kF14Fixed) return;
+  int64_t m = 0;
+  for (size_t i = 0; i < kObsValueWidth; ++i) {
+    if (i != 10) m = m * 10 + ((digit >> i) & 1 ? p[i] - '0' : 0);
+  }
+  f.mantissa = m;
+}
+
+static void f14_pair_scalar(const char* a, const char* b, F14Field* out) {
+  f14_scalar(a, out[0]);
+  f14_scalar(b, out[1]);
+}
+
+#else
+
+// digit groups q[0..3] of a kF14Fixed value: integer digits 0-1, 2-5, 6-9, decimals
+static int64_t f14_mantissa(const uint32_t* q) {
+  return (int64_t)q[0] * 100000000000 + (int64_t)q[1] * 10000000 + (int64_t)q[2] * 1000 + q[3];
+}
+
+// bytes to two-digit pairs to four-digit groups; digits holds 0-9 per byte
+static __m128i f14_groups_sse2(__m128i digits) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i w10 = _mm_set1_epi32(0x0001000a);  // 10, 1
+  const __m128i w100 = _mm_set1_epi32(0x00010064); // 100, 1
+  __m128i d = _mm_slli_si128(digits, 2);
+  __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(d, zero), w10);
+  __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), w10);
+  return _mm_madd_epi16(_mm_packs_epi32(lo, hi), w100);
+}
+
+static void f14_sse2(const char* p, F14Field& f) {
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i t = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+  __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(9)), t);
+  set_shape(f, (uint32_t)_mm_movemask_epi8(is_digit),
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' '))),
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('-'))),
+            (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('.'))));
+  if (f.shape != kF14Fixed) return;
+  alignas(16) uint32_t q[4];
+  _mm_store_si128((__m128i*)q, f14_groups_sse2(_mm_and_si128(t, is_digit)));
+  f.mantissa = f14_mantissa(q);
+}
+
+static void f14_pair_sse2(const char* a, const char* b, F14Field* out) {
+  f14_sse2(a, out[0]);
+  f14_sse2(b, out[1]);
+}
+
+// both slots in one register, one per 128-bit lane
+__attribute__((target("avx2"))) static void f14_pair_avx2(const char* a, const char* b, F14Field* out) {
+  __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)a)),
+                                      _mm_loadu_si128((const __m128i*)b), 1);
+  __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+  __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(9)), t);
+  uint32_t digit = (uint32_t)_mm256_movemask_epi8(is_digit);
+  uint32_t space = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+  uint32_t minus = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+  uint32_t point = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+  set_shape(out[0], digit, space, minus, point);
+  set_shape(out[1], digit >> 16, space >> 16, minus >> 16, point >> 16);
+  if (out[0].shape != kF14Fixed && out[1].shape != kF14Fixed) return;
+
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i w10 = _mm256_set1_epi32(0x0001000a);
+  const __m256i w100 = _mm256_set1_epi32(0x00010064);
+  __m256i d = _mm256_slli_si256(_mm256_and_si256(t, is_digit), 2);
+  __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(d, zero), w10);
+  __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(d, zero), w10);
+  alignas(32) uint32_t q[8];
+  _mm256_store_si256((__m256i*)q, _mm256_madd_epi16(_mm256_packs_epi32(lo, hi), w100));
+  out[0].mantissa = f14_mantissa(q);
+  out[1].mantissa = f14_mantissa(q + 4);
+}
+
+#endif
+
+struct SlotKernel {
+  F14Pair decode;
+  const char* name;
+};
+
+static SlotKernel select_slot_kernel() {
+#ifdef RINEX_SCAN_X86
+  if (simd_use_avx2()) return {f14_pair_avx2, "avx2"};
+  return {f14_pair_sse2, "sse2"};
+#else
+  return {f14_pair_scalar, "scalar"};
+#endif
+}
+
+static const SlotKernel& slot_kernel() {
+  static const SlotKernel k = select_slot_kernel();
+  return k;
+}
+
+const char* obs_decode_kernel() { return slot_kernel().name; }
+
+// the 16 bytes of the slot at col, from line if they are all there, otherwise copied
+// into pad with the columns past the end of the line blank
+static const char* slot_bytes(std::string_view line, size_t col, char* pad) {
+  if (col + kObsSlotWidth <= line.size()) return line.data() + col;
+  memset(pad, ' ', kObsSlotWidth);
+  if (col < line.size()) memcpy(pad, line.data() + col, line.size() - col);
+  return pad;
+}
+
+static void store_value(const F14Field& f, const char* field, double& v) {
+  if (f.shape == kF14Fixed) {
+    double d = (double)f.mantissa / kPow10[3];
+    v = f.neg ? -d : d;
+  } else if (f.shape == kF14Other) {
+    decode_fixed_field(std::string_view(field, kObsValueWidth), 0, kObsValueWidth, v);
+  }
+}
+
+static void store_value(const F14Field& f, const char* field, int64_t& v) {
+  double d;
+  if (f.shape == kF14Fixed) {
+    v = f.neg ? -f.mantissa : f.mantissa;
+  } else if (f.shape == kF14Other && decode_fixed_field(std::string_view(field, kObsValueWidth), 0, kObsValueWidth, d)) {
+    v = std::llround(d * kPow10[3]);
+  }
+}
+
+template <typename T>
+static void decode_slots(std::string_view line, size_t first_col, size_t slot_base,
+                         const ObsSlot* slots, size_t n, T* values, uint8_t* flags) {
+  F14Pair decode = slot_kernel().decode;
+  char pad[2][kObsSlotWidth];
+  const char* field[2];
+  F14Field f[2];
+  for (size_t i = 0; i < n; i += 2) {
+    size_t m = std::min<size_t>(2, n - i);
+    for (size_t k = 0; k < 2; ++k) {
+      // an odd last slot is paired with a blank one
+      size_t col = k < m ? first_col + (slots[i + k].slot - slot_base) * kObsSlotWidth : line.size();
+      field[k] = slot_bytes(line, col, pad[k]);
+    }
+    decode(field[0], field[1], f);
+    for (size_t k = 0; k < m; ++k) {
+      const ObsSlot& s = slots[i + k];
+      store_value(f[k], field[k], values[s.column]);
+      flags[s.column] = decode_obs_flags(std::string_view(field[k], kObsSlotWidth), 0);
+    }
+  }
+}
+
+void decode_obs_slots(std::string_view line, size_t first_col, size_t slot_base,
+                      const ObsSlot* slots, size_t n, double* values, uint8_t* flags) {
+  decode_slots(line, first_col, slot_base, slots, n, values, flags);
+}
+
+void decode_obs_slots(std::string_view line, size_t first_col, size_t slot_base,
+                      const ObsSlot* slots, size_t n, int64_t* values, uint8_t* flags) {
+  decode_slots(line, first_col, slot_base, slots, n, values, flags);
+}
+
+} // end namespace rinex
@@ -0,0 +1,291 @@
+// File:   Hatanaka.cpp
+// Description:
+// Streaming Compact RINEX (Hatanaka) 1.0 / 3.0 decoder.
+//
+// Each epoch of a Compact RINEX file is an epoch line, a clock line and one data
+// line per satellite. The epoch line is a text difference against the previous one
+// (' ' = unchanged, '&' = blank) unless it starts with '>' (3.0) or '&' (1.0), which
+// re-initializes it. Data lines hold one field per observation type, separated by
+// single blanks: "n&value" starts an arc of difference order n, a plain integer is the
+// n-th order difference of the arc, and an empty field is a missing observation.
+// Values are integers in units of the last printed digit. The rest of the line is the
+// LLI/SSI string, text-differenced against the same satellite's previous string.
+//
+
+#include <algorithm>
+#include <charconv>
+
+#include "../include/Decompress.hpp"
+#include "../include/LineScan.hpp"
+
+namespace rinex {
+
+// column of the satellite list in a Compact RINEX epoch line
+static constexpr size_t kCrxSatCol3 = 41;
+static constexpr size_t kCrxSatCol1 = 32;
+
+// apply the text difference diff to s
+static void repair(std::string& s, std::string_view diff) {
+  if (s.size() < diff.size()) s.resize(diff.size(), ' ');
+  for (size_t i = 0; i < diff.size(); ++i) {
+    if (diff[i] == ' ') continue;
+    s[i] = (diff[i] == '&') ? ' ' : diff[i];
+  }
+}
+
+// append v / 10^decimals as a right aligned fixed point number of the given width
+static void append_fixed(std::string& out, int64_t v, int decimals, size_t width) {
+  char digits[32];
+  bool neg = v < 0;
+  uint64_t u = neg ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+  int n = 0;
+  do {
+    digits[n++] = (char)('0' + u % 10);
+    u /= 10;
+  } while (u > 0 || n <= decimals);
+  size_t len = (size_t)n + 1 + (neg ? 1 : 0);
+  if (len < width) out.append(width - len, ' ');
+  if (neg) out.push_back('-');
+  for (int i = n - 1; i >= 0; --i) {
+    out.push_back(digits[i]);
+    if (i == decimals) out.push_back('.');
+  }
+}
+
+static int int_at(std::string_view s, size_t col, size_t width) {
+  int v = 0;
+  for (size_t i = col; i < col + width && i < s.size(); ++i) {
+    if (s[i] >= '0' && s[i] <= '9') v = v * 10 + (s[i] - '0');
+  }
+  return v;
+}
+
+CrxSource::CrxSource(std::unique_ptr<ByteSource> src)
+    : src_(std::move(src)), scanner_(src_.get()) {
+  flags_.resize(SatId::kIndexCount);
+  arcs_.resize(SatId::kIndexCount);
+  in_prev_.resize(SatId::kIndexCount);
+}
+
+bool CrxSource::next_line(std::string_view& line) {
+  return scanner_.next(line);
+}
+
+size_t CrxSource::num_types(SatId sv) const {
+  return is_v3_ ? sys_types_[(size_t)sv.system()] : v2_types_;
+}
+
+void CrxSource::emit_line(std::string& s) {
+  size_t end = s.find_last_not_of(' ');
+  s.resize(end == std::string::npos ? 0 : end + 1);
+  s.push_back('\n');
+  out_ += s;
+}
+
+bool CrxSource::copy_header() {
+  std::string_view line;
+  if (!next_line(line) || line.find("COMPACT RINEX FORMAT") == std::string_view::npos) return false;
+  if (!next_line(line)) return false; // CRINEX PROG / DATE
+  while (next_line(line)) {
+    emit(line);
+    emit("\n");
+    HeaderLabel label = header_label(line);
+    if (label == HeaderLabel::VersionType) {
+      size_t b = line.find_first_not_of(' ');
+      is_v3_ = b != std::string_view::npos && (line[b] == '3' || line[b] == '4');
+    } else if (label == HeaderLabel::SysObsTypes) {
+      GnssSystem sys = line[0] == ' ' ? GnssSystem::Unknown : system_from_letter(line[0]);
+      if (sys != GnssSystem::Unknown) sys_types_[(size_t)sys] = (size_t)int_at(line, 3, 3);
+    } else if (label == HeaderLabel::TypesOfObserv) {
+      if (line.substr(0, 6).find_first_not_of(' ') != std::string_view::npos) {
+        v2_types_ = (size_t)int_at(line, 0, 6);
+      }
+    } else if (label == HeaderLabel::EndOfHeader) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CrxSource::decode_diff(std::string_view field, Arc& arc, int64_t& value) {
+  int64_t x = 0;
+  bool init = field.size() >= 2 && field[1] == '&';
+  std::string_view num = init ? field.substr(2) : field;
+  auto r = std::from_chars(num.data(), num.data() + num.size(), x);
+  if (r.ec != std::errc()) return false;
+  if (init) {
+    arc.arc_order = field[0] - '0';
+    if (arc.arc_order < 0 || arc.arc_order > 9) return false;
+    arc.order = 0;
+    arc.u[0] = x;
+  } else {
+    if (arc.order < 0) return false; // difference without an arc
+    if (arc.order < arc.arc_order) arc.order++;
+    arc.u[arc.order] = x;
+    for (int k = arc.order; k > 0; --k) arc.u[k - 1] += arc.u[k];
+  }
+  value = arc.u[0];
+  return true;
+}
+
+bool CrxSource::decode_epoch() {
+  std::string_view line;
+  if (!next_line(line)) return false;
+
+  // epoch line: initialization or text difference
+  bool init = !line.empty() && line[0] == (is_v3_ ? '>' : '&');
+  if (init) {
+    epoch_.assign(line.data(), line.size());
+    if (!is_v3_) epoch_[0] = ' ';
+    for (std::string& f : flags_) f.clear();
+  } else {
+    if (epoch_.empty()) return false; // no epoch to difference against
+    repair(epoch_, line);
+  }
+  size_t head_len = is_v3_ ? 35 : 32;
+  int event_flag = int_at(epoch_, is_v3_ ? 31 : 28, 1);
+  int num_sv = int_at(epoch_, is_v3_ ? 32 : 29, 3);
+
+  // event flags 2-5: the epoch line is followed by header records, copied as is
+  if (event_flag >= 2 && event_flag <= 5) {
+    line_.assign(epoch_, 0, std::min(epoch_.size(), head_len));
+    emit_line(line_);
+    for (int i = 0; i < num_sv && next_line(line); ++i) {
+      emit(line);
+      emit("\n");
+    }
+    epoch_.clear();
+    return true;
+  }
+
+  // receiver clock offset line (blank if there is none)
+  std::string_view clk;
+  if (!next_line(clk)) return false;
+  int64_t clock = 0;
+  bool has_clock = false;
+  if (!clk.empty()) {
+    has_clock = decode_diff(clk, clock_, clock);
+  } else {
+    clock_.order = -1;
+  }
+
+  // epoch record(s) with the clock offset
+  size_t sat_col = is_v3_ ? kCrxSatCol3 : kCrxSatCol1;
+  line_.assign(epoch_, 0, std::min(epoch_.size(), head_len));
+  line_.resize(head_len, ' ');
+  if (is_v3_) {
+    if (has_clock) {
+      line_.append(6, ' ');
+      append_fixed(line_, clock, 12, 15);
+    }
+    emit_line(line_);
+  } else {
+    for (int i = 0; i < num_sv; ++i) {
+      if (i > 0 && i % 12 == 0) {
+        if (i == 12 && has_clock) {
+          line_.resize(68, ' ');
+          append_fixed(line_, clock, 9, 12);
+        }
+        emit_line(line_);
+        line_.assign(32, ' ');
+      }
+      size_t col = sat_col + 3 * (size_t)i;
+      line_.append(col < epoch_.size() ? epoch_.substr(col, 3) : std::string("   "));
+    }
+    if (num_sv <= 12 && has_clock) {
+      line_.resize(68, ' ');
+      append_fixed(line_, clock, 9, 12);
+    }
+    emit_line(line_);
+  }
+
+  // One data line per satellite. A satellite that was not in the previous epoch starts
+  // over: its fields and flags are differenced against nothing, as rnx2crx writes them.
+  for (uint16_t idx : prev_sats_) in_prev_[idx] = 1;
+  cur_sats_.clear();
+  for (int i = 0; i < num_sv; ++i) {
+    if (!next_line(line)) return false;
+    size_t col = sat_col + 3 * (size_t)i;
+    std::string_view id = col < epoch_.size() ? std::string_view(epoch_).substr(col, 3) : std::string_view();
+    SatId sv = SatId::parse(id);
+    size_t ntypes = std::min(num_types(sv), kMaxTypes);
+    size_t idx = sv.index();
+    std::vector<Arc>& arcs = arcs_[idx];
+    if (!in_prev_[idx]) {
+      for (Arc& a : arcs) a.order = -1;
+      flags_[idx].clear();
+    }
+    cur_sats_.push_back((uint16_t)idx);
+    if (arcs.size() < ntypes) arcs.resize(ntypes);
+
+    // observation fields, then the differenced LLI/SSI string
+    line_.clear();
+    if (is_v3_) line_.append(id.data(), id.size());
+    size_t p = 0;
+    std::string& values = values_;
+    values.clear();
+    for (size_t j = 0; j < ntypes; ++j) {
+      int64_t v = 0;
+      bool present = false;
+      if (p < line.size() && line[p] != ' ') {
+        size_t e = line.find(' ', p);
+        if (e == std::string_view::npos) e = line.size();
+        present = decode_diff(line.substr(p, e - p), arcs[j], v);
+        if (!present) failed_ = true;
+        p = e;
+      } else {
+        arcs[j].order = -1; // missing value ends the arc
+      }
+      if (p < line.size()) ++p; // field separator
+      if (present) {
+        append_fixed(values, v, 3, 14);
+      } else {
+        values.append(14, ' ');
+      }
+      values.append(2, ' '); // LLI and SSI, filled in below
+    }
+    std::string& flags = flags_[idx];
+    if (p < line.size()) repair(flags, line.substr(p));
+    for (size_t j = 0; j < ntypes; ++j) {
+      if (2 * j < flags.size()) values[16 * j + 14] = flags[2 * j];
+      if (2 * j + 1 < flags.size()) values[16 * j + 15] = flags[2 * j + 1];
+    }
+
+    if (is_v3_) {
+      line_ += values;
+      emit_line(line_);
+    } else {
+      // RINEX 2 wraps the observations at five per line
+      for (size_t j = 0; j < ntypes || j == 0; j += 5) {
+        line_.assign(values, 16 * j, 16 * 5);
+        emit_line(line_);
+      }
+    }
+  }
+  for (uint16_t idx : prev_sats_) in_prev_[idx] = 0;
+  prev_sats_.swap(cur_sats_);
+  return !failed_;
+}
+
+size_t CrxSource::read(char* buf, size_t n) {
+  while (out_pos_ == out_.size() && !done_) {
+    out_.clear();
+    out_pos_ = 0;
+    if (in_header_) {
+      in_header_ = false;
+      if (!copy_header()) {
+        failed_ = true;
+        done_ = true;
+      }
+    } else if (!decode_epoch()) {
+      failed_ = failed_ || src_->failed();
+      done_ = true;
+    }
+  }
+  size_t k = std::min(n, out_.size() - out_pos_);
+  out_.copy(buf, k, out_pos_);
+  out_pos_ += k;
+  return k;
+}
+
+} // end namespace rinex
@@ -0,0 +1,170 @@
+// File:   LineScan.cpp
+// Description:
+// Vectorized newline search and header label classification.
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "../include/LineScan.hpp"
+
+#if !defined(RINEX_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RINEX_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace rinex {
+
+static const char* find_newline_scalar(const char* p, const char* end) {
+  const void* nl = p < end ? memchr(p, '\n', (size_t)(end - p)) : nullptr;
+  return nl ? static_cast<const char*>(nl) : end;
+}
+
+#ifdef RINEX_SCAN_X86
+
+static const char* find_newline_sse2(const char* p, const char* end) {
+  const __m128i nl = _mm_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), nl);
+    __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), nl);
+    uint32_t m = (uint32_t)_mm_movemask_epi8(a) | ((uint32_t)_mm_movemask_epi8(b) << 16);
+    if (m) return p + __builtin_ctz(m);
+  }
+  return find_newline_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char* find_newline_avx2(const char* p, const char* end) {
+  const __m256i nl = _mm256_set1_epi8('\n');
+  for (; end - p >= 64; p += 64) {
+    __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), nl);
+    __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), nl);
+    uint64_t m = (uint32_t)_mm256_movemask_epi8(a) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(b) << 32);
+    if (m) return p + __builtin_ctzll(m);
+  }
+  return find_newline_sse2(p, end);
+}
+
+#endif
+
+using FindNewline = const char* (*)(const char*, const char*);
+
+struct ScanKernel {
+  FindNewline find_newline;
+  const char* name;
+};
+
+bool simd_use_avx2() {
+#ifdef RINEX_SCAN_X86
+  static const bool avx2 = __builtin_cpu_supports("avx2") && !std::getenv("RINEX_NO_AVX2");
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+static ScanKernel select_kernel() {
+#ifdef RINEX_SCAN_X86
+  if (simd_use_avx2()) return {find_newline_avx2, "avx2"};
+  return {find_newline_sse2, "sse2"};
+#else
+  return {find_newline_scalar, "scalar"};
+#endif
+}
+
+static const ScanKernel& kernel() {
+  static const ScanKernel k = select_kernel();
+  return k;
+}
+
+const char* find_newline(const char* p, const char* end) { return kernel().find_newline(p, end); }
+
+const char* line_scan_kernel() { return kernel().name; }
+
+// labels in the order of HeaderLabel, starting at VersionType
+static const char* const kLabels[] = {
+    "RINEX VERSION / TYPE", "PGM / RUN BY / DATE", "COMMENT", "MARKER NAME", "MARKER NUMBER",
+    "MARKER TYPE", "OBSERVER / AGENCY", "REC # / TYPE / VERS", "ANT # / TYPE",
+    "APPROX POSITION XYZ", "ANTENNA: DELTA H/E/N", "ANTENNA: DELTA X/Y/Z", "WAVELENGTH FACT L1/2",
+    "# / TYPES OF OBSERV", "SYS / # / OBS TYPES", "SIGNAL STRENGTH UNIT", "INTERVAL",
+    "TIME OF FIRST OBS", "TIME OF LAST OBS", "RCV CLOCK OFFS APPL", "SYS / DCBS APPLIED",
+    "SYS / PCVS APPLIED", "SYS / SCALE FACTOR", "SYS / PHASE SHIFT", "GLONASS SLOT / FRQ #",
+    "GLONASS COD/PHS/BIS", "LEAP SECONDS", "# OF SATELLITES", "PRN / # OF OBS", "END OF HEADER"};
+constexpr size_t kNumLabels = sizeof(kLabels) / sizeof(kLabels[0]);
+static_assert(kNumLabels == (size_t)HeaderLabel::EndOfHeader, "kLabels out of step with HeaderLabel");
+
+// a label slot padded with blanks to 32 bytes, so it can be loaded as whole words
+struct LabelKey {
+  alignas(16) char c[32];
+};
+
+static void make_key(std::string_view label, LabelKey& key) {
+  memset(key.c, ' ', sizeof(key.c));
+  memcpy(key.c, label.data(), std::min(label.size(), kHeaderLabelWidth));
+}
+
+static uint64_t load64(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+constexpr size_t kTableSize = 128; // power of two, well above kNumLabels
+
+static size_t key_hash(const LabelKey& key) {
+  uint64_t h = load64(key.c) * 0x9e3779b97f4a7c15ull ^ load64(key.c + 8) * 0xc2b2ae3d27d4eb4full;
+  return (size_t)(h >> 57) & (kTableSize - 1);
+}
+
+static bool same_key(const LabelKey& a, const LabelKey& b) {
+#ifdef RINEX_SCAN_X86
+  __m128i lo = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)a.c), _mm_load_si128((const __m128i*)b.c));
+  __m128i hi = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(a.c + 16)),
+                              _mm_load_si128((const __m128i*)(b.c + 16)));
+  return (_mm_movemask_epi8(_mm_and_si128(lo, hi)) & 0xffff) == 0xffff;
+#else
+  return memcmp(a.c, b.c, sizeof(a.c)) == 0;
+#endif
+}
+
+// open addressing table of the padded labels; slot value 0 is empty
+struct LabelTable {
+  LabelKey keys[kNumLabels + 1];
+  uint8_t slot[kTableSize] = {};
+
+  LabelTable() {
+    for (size_t i = 0; i < kNumLabels; ++i) {
+      LabelKey& key = keys[i + 1];
+      make_key(kLabels[i], key);
+      size_t h = key_hash(key);
+      while (slot[h]) h = (h + 1) & (kTableSize - 1);
+      slot[h] = (uint8_t)(i + 1);
+    }
+  }
+
+  HeaderLabel find(const LabelKey& key) const {
+    for (size_t h = key_hash(key); slot[h]; h = (h + 1) & (kTableSize - 1)) {
+      if (same_key(keys[slot[h]], key)) return (HeaderLabel)slot[h];
+    }
+    return HeaderLabel::Unknown;
+  }
+};
+
+HeaderLabel header_label(std::string_view line) {
+  static const LabelTable table;
+  if (line.size() > kHeaderLabelCol) {
+    LabelKey key; // right-trimmed lines simply end early in the slot
+    make_key(line.substr(kHeaderLabelCol, kHeaderLabelWidth), key);
+    HeaderLabel label = table.find(key);
+    if (label != HeaderLabel::Unknown) return label;
+  }
+  // misplaced label: look for the ones the parser needs anywhere on the line
+  static const HeaderLabel kSearched[] = {HeaderLabel::VersionType, HeaderLabel::SysObsTypes,
+                                          HeaderLabel::TypesOfObserv, HeaderLabel::EndOfHeader};
+  for (HeaderLabel l : kSearched) {
+    if (line.find(kLabels[(size_t)l - 1]) != std::string_view::npos) return l;
+  }
+  return HeaderLabel::Unknown;
+}
+
+} // end namespace rinex
@@ -0,0 +1,114 @@
+// File:   MappedFile.cpp
+// Description:
+// Read-only memory mapping of RINEX files with a plain read() fallback, and the
+// refill path of LineScanner for streamed input.
+//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "../include/ByteSource.hpp"
+#include "../include/MappedFile.hpp"
+
+namespace rinex {
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this == &other) return *this;
+  close();
+  mapped_ = other.mapped_;
+  open_ = other.open_;
+  size_ = other.size_;
+  fallback_ = std::move(other.fallback_);
+  data_ = mapped_ ? other.data_ : fallback_.data();
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.open_ = false;
+  other.mapped_ = false;
+  return *this;
+}
+
+bool file_stamp(const std::string& path, uint64_t& size, int64_t& mtime) {
+  struct stat st;
+  if (path.empty() || stat(path.c_str(), &st) != 0) return false;
+  size = (uint64_t)st.st_size;
+  mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+bool MappedFile::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      // the parser walks the file front to back exactly once
+      madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(p);
+      size_ = (size_t)st.st_size;
+      mapped_ = true;
+      open_ = true;
+      ::close(fd);
+      return true;
+    }
+  }
+
+  // could not map (empty file, pipe, ...): read everything into memory
+  char buf[1 << 16];
+  ssize_t n;
+  while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+    fallback_.insert(fallback_.end(), buf, buf + n);
+  }
+  ::close(fd);
+  if (n < 0) {
+    fallback_.clear();
+    return false;
+  }
+  data_ = fallback_.data();
+  size_ = fallback_.size();
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (mapped_ && data_) munmap(const_cast<char*>(data_), size_);
+  fallback_.clear();
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+  mapped_ = false;
+}
+
+size_t LineScanner::refill() {
+  constexpr size_t kChunk = 1 << 18;
+
+  // drop the consumed bytes and keep the unfinished line at the front
+  size_t keep = buf_.size() - pos_;
+  if (keep > 0 && pos_ > 0) memmove(storage_.data(), storage_.data() + pos_, keep);
+  base_ += pos_;
+  pos_ = 0;
+  size_t fill = keep;
+
+  while (true) {
+    if (storage_.size() - fill < kChunk) storage_.resize(std::max(2 * storage_.size(), fill + kChunk));
+    size_t n = src_->read(storage_.data() + fill, storage_.size() - fill);
+    const char* nl = find_newline(storage_.data() + fill, storage_.data() + fill + n);
+    fill += n;
+    buf_ = std::string_view(storage_.data(), fill);
+    if (nl != storage_.data() + fill) return (size_t)(nl - storage_.data());
+    if (n == 0) return std::string_view::npos;
+  }
+}
+
+} // end namespace rinex
@@ -0,0 +1,308 @@
+// File:   ObsCache.cpp
+// Description:
+// Binary columnar cache of parsed RINEX observation files.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "../include/ObsCache.hpp"
+
+namespace rinex {
+
+static constexpr char kCacheMagic[8] = {'R', 'N', 'X', 'O', 'B', 'S', 'C', '1'};
+static constexpr uint32_t kCacheVersion = 4;
+static constexpr size_t kCodeWidth = 4; // observation codes are stored as 4 byte fields
+
+// sections of a cache file, in file order
+enum CacheSection {
+  kTypes,      // obs_types, then kNumSystems counts and each system's codes
+  kEpochTime,
+  kEpochFlag,
+  kEpochBegin,
+  kSats,
+  kRowSat,
+  kColumns,    // doubles, or int64 thousandths in fixed-point caches
+  kFlags,      // LLI/SSI columns, one byte per value
+  kNumSections
+};
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t is_v3;
+  uint32_t num_types;
+  uint32_t fixed_point;
+  uint64_t num_epochs;
+  uint64_t num_rows;
+  uint64_t num_sats;
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t offset[kNumSections + 1]; // section bounds; offset[kNumSections] is the file size
+};
+
+static size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+// a * b, false if it does not fit
+static bool checked_mul(uint64_t a, uint64_t b, uint64_t& out) {
+  if (b != 0 && a > UINT64_MAX / b) return false;
+  out = a * b;
+  return true;
+}
+
+static void put_code(std::string& out, const std::string& code) {
+  char f[kCodeWidth] = {};
+  memcpy(f, code.data(), std::min(code.size(), kCodeWidth));
+  out.append(f, kCodeWidth);
+}
+
+static std::string get_code(const char* p) {
+  size_t n = 0;
+  while (n < kCodeWidth && p[n] != '\0') ++n;
+  return std::string(p, n);
+}
+
+bool write_obs_cache(const std::string& path, const RinexObs& obs, const std::string& source_path) {
+  CacheHeader hdr = {};
+  memcpy(hdr.magic, kCacheMagic, sizeof(kCacheMagic));
+  hdr.version = kCacheVersion;
+  hdr.is_v3 = obs.is_v3 ? 1 : 0;
+  hdr.num_types = (uint32_t)obs.obs_types.size();
+  hdr.fixed_point = obs.fixed_point ? 1 : 0;
+  hdr.num_epochs = obs.num_epochs();
+  hdr.num_rows = obs.num_rows();
+  hdr.num_sats = obs.sats.size();
+  file_stamp(source_path, hdr.source_size, hdr.source_mtime);
+
+  // observation type tables
+  std::string types;
+  for (const std::string& code : obs.obs_types) put_code(types, code);
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    uint32_t n = (uint32_t)obs.sys_obs_types[s].size();
+    types.append(reinterpret_cast<const char*>(&n), sizeof(n));
+  }
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    for (const std::string& code : obs.sys_obs_types[s]) put_code(types, code);
+  }
+
+  std::vector<uint16_t> sat_codes(obs.sats.size());
+  for (size_t i = 0; i < obs.sats.size(); ++i) sat_codes[i] = obs.sats[i].code();
+
+  // the observation columns of the storage in use
+  size_t num_columns = obs.fixed_point ? obs.obs_fixed.size() : obs.obs.size();
+  const size_t sizes[kNumSections] = {
+      types.size(),
+      obs.epoch_time.size() * sizeof(int64_t),
+      obs.epoch_flag.size(),
+      obs.epoch_begin.size() * sizeof(uint32_t),
+      sat_codes.size() * sizeof(uint16_t),
+      obs.row_sat.size() * sizeof(uint16_t),
+      num_columns * obs.num_rows() * sizeof(double), // int64 columns are as large
+      obs.flags.size() * obs.num_rows()};
+  hdr.offset[0] = align8(sizeof(CacheHeader));
+  for (size_t k = 0; k < kNumSections; ++k) hdr.offset[k + 1] = align8(hdr.offset[k] + sizes[k]);
+
+  std::string tmp = path + ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  if (!f) return false;
+  static const char zeros[8] = {};
+  size_t pos = 0;
+  auto put = [&](const void* p, size_t n) {
+    f.write(static_cast<const char*>(p), (std::streamsize)n);
+    pos += n;
+  };
+  auto pad = [&]() { put(zeros, align8(pos) - pos); };
+
+  put(&hdr, sizeof(hdr));
+  pad();
+  put(types.data(), types.size());
+  pad();
+  put(obs.epoch_time.data(), sizes[kEpochTime]);
+  pad();
+  put(obs.epoch_flag.data(), sizes[kEpochFlag]);
+  pad();
+  put(obs.epoch_begin.data(), sizes[kEpochBegin]);
+  pad();
+  put(sat_codes.data(), sizes[kSats]);
+  pad();
+  put(obs.row_sat.data(), sizes[kRowSat]);
+  pad();
+  if (obs.fixed_point) {
+    for (const auto& col : obs.obs_fixed) put(col.data(), col.size() * sizeof(int64_t));
+  } else {
+    for (const auto& col : obs.obs) put(col.data(), col.size() * sizeof(double));
+  }
+  pad();
+  for (const auto& col : obs.flags) put(col.data(), col.size());
+  pad();
+  f.close();
+  if (!f || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+ParseRinexError ObsCache::open(const std::string& path) {
+  close();
+  if (!file_.open(path)) return ParseRinexError::FileNotFound;
+
+  CacheHeader hdr;
+  if (file_.size() < sizeof(hdr)) return ParseRinexError::InvalidCache;
+  memcpy(&hdr, file_.data(), sizeof(hdr));
+  if (memcmp(hdr.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || hdr.version != kCacheVersion) {
+    return ParseRinexError::InvalidCache;
+  }
+
+  // every section has to lie inside the file and be as large as its counts say
+  uint64_t sizes[kNumSections] = {};
+  uint64_t values = 0;
+  if (!checked_mul(hdr.num_types, hdr.num_rows, values) ||
+      !checked_mul(hdr.num_epochs, sizeof(int64_t), sizes[kEpochTime]) ||
+      !checked_mul(hdr.num_epochs, sizeof(uint32_t), sizes[kEpochBegin]) ||
+      !checked_mul(hdr.num_sats, sizeof(uint16_t), sizes[kSats]) ||
+      !checked_mul(hdr.num_rows, sizeof(uint16_t), sizes[kRowSat]) ||
+      !checked_mul(values, sizeof(double), sizes[kColumns])) {
+    return ParseRinexError::InvalidCache;
+  }
+  sizes[kTypes] = (uint64_t)hdr.num_types * kCodeWidth + kNumSystems * sizeof(uint32_t);
+  sizes[kEpochFlag] = hdr.num_epochs;
+  sizes[kFlags] = values;
+  for (size_t k = 0; k < kNumSections; ++k) {
+    if (hdr.offset[k] % 8 != 0 || hdr.offset[k] > hdr.offset[k + 1] ||
+        hdr.offset[k + 1] - hdr.offset[k] < sizes[k]) {
+      return ParseRinexError::InvalidCache;
+    }
+  }
+  if (hdr.offset[0] < sizeof(hdr) || hdr.offset[kNumSections] > file_.size()) {
+    return ParseRinexError::InvalidCache;
+  }
+
+  // type tables
+  const char* base = file_.data();
+  const char* p = base + hdr.offset[kTypes];
+  const char* types_end = base + hdr.offset[kTypes + 1];
+  header_ = RinexHeader();
+  header_.is_v3 = hdr.is_v3 != 0;
+  header_.fixed_point = hdr.fixed_point != 0;
+  for (uint32_t t = 0; t < hdr.num_types; ++t, p += kCodeWidth) header_.obs_types.push_back(get_code(p));
+  uint32_t counts[kNumSystems];
+  memcpy(counts, p, sizeof(counts));
+  p += sizeof(counts);
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    if ((size_t)(types_end - p) < counts[s] * kCodeWidth) return ParseRinexError::InvalidCache;
+    for (uint32_t j = 0; j < counts[s]; ++j, p += kCodeWidth) header_.sys_obs_types[s].push_back(get_code(p));
+  }
+  if (select_obs_types(header_, header_.obs_types) != ParseRinexError::Success) {
+    return ParseRinexError::InvalidCache;
+  }
+
+  // the tables that index the columns: epochs start at row 0 and never go back, and
+  // every row refers to a satellite of the table
+  const uint32_t* epoch_begin = reinterpret_cast<const uint32_t*>(base + hdr.offset[kEpochBegin]);
+  const uint16_t* sats = reinterpret_cast<const uint16_t*>(base + hdr.offset[kSats]);
+  const uint16_t* row_sat = reinterpret_cast<const uint16_t*>(base + hdr.offset[kRowSat]);
+  if (hdr.num_epochs == 0 ? hdr.num_rows != 0 : epoch_begin[0] != 0) return ParseRinexError::InvalidCache;
+  for (uint64_t e = 0; e < hdr.num_epochs; ++e) {
+    if (epoch_begin[e] > hdr.num_rows || (e > 0 && epoch_begin[e] < epoch_begin[e - 1])) {
+      return ParseRinexError::InvalidCache;
+    }
+  }
+  for (uint64_t i = 0; i < hdr.num_sats; ++i) {
+    if ((sats[i] >> 8) >= kNumSystems) return ParseRinexError::InvalidCache;
+  }
+  for (uint64_t r = 0; r < hdr.num_rows; ++r) {
+    if (row_sat[r] >= hdr.num_sats) return ParseRinexError::InvalidCache;
+  }
+
+  num_epochs_ = hdr.num_epochs;
+  num_rows_ = hdr.num_rows;
+  num_sats_ = hdr.num_sats;
+  source_size_ = hdr.source_size;
+  source_mtime_ = hdr.source_mtime;
+  epoch_time_ = reinterpret_cast<const int64_t*>(base + hdr.offset[kEpochTime]);
+  epoch_flag_ = reinterpret_cast<const uint8_t*>(base + hdr.offset[kEpochFlag]);
+  epoch_begin_ = epoch_begin;
+  sats_ = sats;
+  row_sat_ = row_sat;
+  if (header_.fixed_point) fixed_columns_ = reinterpret_cast<const int64_t*>(base + hdr.offset[kColumns]);
+  else columns_ = reinterpret_cast<const double*>(base + hdr.offset[kColumns]);
+  flags_ = reinterpret_cast<const uint8_t*>(base + hdr.offset[kFlags]);
+  return ParseRinexError::Success;
+}
+
+void ObsCache::close() {
+  file_.close();
+  header_ = RinexHeader();
+  num_epochs_ = num_rows_ = num_sats_ = 0;
+  source_size_ = 0;
+  source_mtime_ = 0;
+  epoch_time_ = nullptr;
+  epoch_flag_ = nullptr;
+  epoch_begin_ = nullptr;
+  sats_ = nullptr;
+  row_sat_ = nullptr;
+  columns_ = nullptr;
+  fixed_columns_ = nullptr;
+  flags_ = nullptr;
+}
+
+void ObsCache::copy_to(RinexObs& out) const {
+  static_cast<RinexHeader&>(out) = header_;
+  out.reset_columns();
+  out.epoch_time.assign(epoch_time_, epoch_time_ + num_epochs_);
+  out.epoch_flag.assign(epoch_flag_, epoch_flag_ + num_epochs_);
+  out.epoch_begin.assign(epoch_begin_, epoch_begin_ + num_epochs_);
+  out.sats.resize(num_sats_);
+  for (size_t i = 0; i < num_sats_; ++i) out.sats[i] = sat(i);
+  out.row_sat.assign(row_sat_, row_sat_ + num_rows_);
+  for (size_t t = 0; t < out.obs.size(); ++t) out.obs[t].assign(column(t), column(t) + num_rows_);
+  for (size_t t = 0; t < out.obs_fixed.size(); ++t) {
+    out.obs_fixed[t].assign(fixed_column(t), fixed_column(t) + num_rows_);
+  }
+  for (size_t t = 0; t < out.flags.size(); ++t) out.flags[t].assign(flags(t), flags(t) + num_rows_);
+  out.index_sats();
+}
+
+ParseRinexError read_obs_cache(const std::string& path, RinexObs& out) {
+  ObsCache cache;
+  ParseRinexError err = cache.open(path);
+  if (err != ParseRinexError::Success) return err;
+  cache.copy_to(out);
+  return ParseRinexError::Success;
+}
+
+// True if cache holds the observation codes opts asks for, in the storage it asks for.
+// The request goes through select_obs_types as in a parse, so codes missing from the
+// file, repeated or out of header order select what they selected when it was cached.
+static bool same_selection(const RinexHeader& cached, const ParseOptions& opts) {
+  if (cached.fixed_point != opts.fixed_point) return false;
+  RinexHeader wanted = cached;
+  return select_obs_types(wanted, opts.obs_codes) == ParseRinexError::Success &&
+         wanted.obs_types == cached.obs_types;
+}
+
+ParseRinexError parse_rinex_obs_cached(const std::string& path, const std::string& cache_path,
+                                       RinexObs& out, const ParseOptions& opts) {
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  bool have_source = file_stamp(path, size, mtime);
+  ObsCache cache;
+  if (cache.open(cache_path) == ParseRinexError::Success &&
+      (!have_source || (cache.source_size() == size && cache.source_mtime() == mtime)) &&
+      same_selection(cache.header(), opts)) {
+    cache.copy_to(out);
+    return ParseRinexError::Success;
+  }
+  cache.close();
+
+  ParseRinexError err = parse_rinex_obs(path, out, opts);
+  if (err != ParseRinexError::Success) return err;
+  write_obs_cache(cache_path, out, path); // a cache that cannot be written is not an error
+  return ParseRinexError::Success;
+}
+
+} // end namespace rinex
@@ -0,0 +1,104 @@
+// File:   ObsFlags.cpp
+// Description:
+// Vectorized scans over packed LLI/SSI flag columns.
+//
+
+#include "../include/ObsFlags.hpp"
+#include "../include/LineScan.hpp"
+
+#if !defined(RINEX_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RINEX_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace rinex {
+
+// Bit i of the result is set if flags[i] & mask, for 64 flags starting at flags.
+// The kernels differ only in how many bytes they test per instruction.
+using FlagMask64 = uint64_t (*)(const uint8_t* flags, uint8_t mask);
+
+#ifndef RINEX_SCAN_X86
+
+static uint64_t flag_mask64_scalar(const uint8_t* flags, uint8_t mask) {
+  uint64_t m = 0;
+  for (size_t i = 0; i < 64; ++i) m |= (uint64_t)((flags[i] & mask) != 0) << i;
+  return m;
+}
+
+#else
+
+static uint64_t flag_mask64_sse2(const uint8_t* flags, uint8_t mask) {
+  const __m128i mk = _mm_set1_epi8((char)mask);
+  const __m128i zero = _mm_setzero_si128();
+  uint64_t m = 0;
+  for (size_t k = 0; k < 4; ++k) {
+    __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)(flags + 16 * k)), mk);
+    uint32_t z = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+    m |= (uint64_t)(~z & 0xffff) << (16 * k);
+  }
+  return m;
+}
+
+__attribute__((target("avx2"))) static uint64_t flag_mask64_avx2(const uint8_t* flags, uint8_t mask) {
+  const __m256i mk = _mm256_set1_epi8((char)mask);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)flags), mk);
+  __m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(flags + 32)), mk);
+  uint64_t za = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero));
+  uint64_t zb = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, zero));
+  return ~(za | (zb << 32));
+}
+
+#endif
+
+static FlagMask64 flag_kernel() {
+#ifdef RINEX_SCAN_X86
+  static const FlagMask64 k = simd_use_avx2() ? flag_mask64_avx2 : flag_mask64_sse2;
+#else
+  static const FlagMask64 k = flag_mask64_scalar;
+#endif
+  return k;
+}
+
+// Call fn(i) for every flagged i in [from, n) in order, until it returns false
+template <typename Fn>
+static void for_each_flagged(const uint8_t* flags, size_t n, uint8_t mask, size_t from, Fn fn) {
+  FlagMask64 block_mask = flag_kernel();
+  size_t i = from;
+  for (; i + 64 <= n; i += 64) {
+    for (uint64_t m = block_mask(flags + i, mask); m; m &= m - 1) {
+      if (!fn(i + (size_t)__builtin_ctzll(m))) return;
+    }
+  }
+  for (; i < n; ++i) {
+    if ((flags[i] & mask) && !fn(i)) return;
+  }
+}
+
+size_t find_flagged(const uint8_t* flags, size_t n, uint8_t mask, size_t from) {
+  size_t found = n;
+  for_each_flagged(flags, n, mask, from, [&](size_t i) {
+    found = i;
+    return false;
+  });
+  return found;
+}
+
+size_t count_flagged(const uint8_t* flags, size_t n, uint8_t mask) {
+  FlagMask64 block_mask = flag_kernel();
+  size_t count = 0, i = 0;
+  for (; i + 64 <= n; i += 64) count += (size_t)__builtin_popcountll(block_mask(flags + i, mask));
+  for (; i < n; ++i) count += (flags[i] & mask) != 0;
+  return count;
+}
+
+std::vector<uint32_t> flagged_rows(const uint8_t* flags, size_t n, uint8_t mask) {
+  std::vector<uint32_t> rows;
+  for_each_flagged(flags, n, mask, 0, [&](size_t i) {
+    rows.push_back((uint32_t)i);
+    return true;
+  });
+  return rows;
+}
+
+} // end namespace rinex
@@ -5,16 +5,22 @@
 // Read GNSS observables from a RINEX file and store obs in CSV format
 //
  
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <memory>
 #include <string>
+#include <thread>
 
 #include "../include/ParseRinex.hpp"
+#include "../include/EpochReader.hpp"
+#include "../include/LineScan.hpp"
+#include "../include/ObsFlags.hpp"
+#include "../include/ParseStats.hpp"
+#include "../include/ThreadPool.hpp"
 
 namespace rinex {
 
-bool is_number(const std::string &s){
+bool is_number(std::string_view s){
     bool dot=false, sign=false, digit=false;
     for(char c: s){
         if(c==' '||c=='\t') continue;
@@ -26,307 +32,565 @@ bool is_number(const std::string &s){
     return digit;
 }
 
-std::string trim(const std::string &s){
+std::string_view trim_view(std::string_view s){
     size_t b = s.find_first_not_of(" \t\r\n");
-    if(b==std::string::npos) return "";
+    if(b==std::string_view::npos) return std::string_view();
     size_t e = s.find_last_not_of(" \t\r\n");
     return s.substr(b,e-b+1);
 }
 
-bool is_rinex_v3(const std::string& line) {
-    if(line.size() >= 20 && line.find("RINEX VERSION / TYPE") != std::string::npos) {
-        std::string v = rinex::trim(line.substr(0, 20));
+std::string trim(std::string_view s){
+    return std::string(trim_view(s));
+}
+
+// return the next whitespace delimited token of s starting at pos, advancing pos
+static std::string_view next_token(std::string_view s, size_t& pos){
+    while (pos < s.size() && isspace((unsigned char)s[pos])) ++pos;
+    size_t start = pos;
+    while (pos < s.size() && !isspace((unsigned char)s[pos])) ++pos;
+    return s.substr(start, pos - start);
+}
+
+// integer value of a token; false if the token is not entirely an integer
+static bool to_int(std::string_view t, int& v){
+    if (!t.empty() && t[0] == '+') t.remove_prefix(1);
+    auto r = std::from_chars(t.data(), t.data() + t.size(), v);
+    return !t.empty() && r.ec == std::errc() && r.ptr == t.data() + t.size();
+}
+
+bool is_rinex_v3(std::string_view line) {
+    if(line.size() >= 20 && line.find("RINEX VERSION / TYPE") != std::string_view::npos) {
+        std::string_view v = rinex::trim_view(line.substr(0, 20));
         if(!v.empty() && (v[0] == '3' || v[0] == '4')) return true;
     }
     return false;
 }
 
 std::vector<std::string> extract_obs_types_from_line(
-    const std::string& line,
+    std::string_view line,
     size_t skip_chars,
     int min_len,
     int max_len, 
     const std::string& valid_start
   )
 {
-    std::string obs_str = line.substr(skip_chars);
-    std::vector<std::string> words;
+    std::vector<std::string> fld;
+    if (skip_chars >= line.size()) return fld;
+    std::string_view obs_str = line.substr(skip_chars);
     size_t pos = 0;
     while (pos < obs_str.size()) {
-        while (pos < obs_str.size() && isspace(obs_str[pos])) ++pos;
-        size_t start = pos;
-        while (pos < obs_str.size() && !isspace(obs_str[pos])) ++pos;
-        if (start < pos) words.push_back(obs_str.substr(start, pos - start));
-    }
-    std::vector<std::string> fld;
-    for (const auto& w : words) {
-        if (w.size() >= min_len && w.size() <= max_len &&
+        std::string_view w = next_token(obs_str, pos);
+        if (w.empty()) break;
+        if ((int)w.size() >= min_len && (int)w.size() <= max_len &&
             valid_start.find(w[0]) != std::string::npos) {
-            fld.push_back(w);
+            fld.emplace_back(w);
         }
     }
     return fld;
 }
 
-bool is_gps_sat(const std::string &sv){
+bool is_gps_sat(std::string_view sv){
     if(sv.empty()) return false;
     if(sv[0]=='G') return true;
     if(isdigit(sv[0])) return true;
     return false;
 }
 
-std::string normalize_sat_id(const std::string &sv){
-    std::string t=trim(sv);
-    if(t.empty()) return t;
-    if(t[0]=='G') return t; // already RINEX-3 style
-
-    // RINEX-2 numeric PRN -> prefix G
-    if(isdigit(t[0])){
-      try {
-        int prn = std::stoi(t);
-        char buf[8]; snprintf(buf,sizeof(buf),"G%02d", prn);
-        return std::string(buf);
-      } catch (...) {
-        // could not convert string to int
-        return t; // fallback: return as-is
-      }
-    }
-    return t;
+std::string normalize_sat_id(std::string_view sv){
+    // RINEX-2 numeric PRN -> prefix G, "G 5" -> "G05"
+    SatId id = SatId::parse(sv);
+    if (id.valid()) return id.to_string();
+    return std::string(trim_view(sv)); // fallback: return as-is
 }
 
-inline int parse_obs_type_count(const std::string& line) {
-  std::istringstream iss(line);
-  std::string token1, token2;
-  iss >> token1 >> token2;
+int parse_obs_type_count(std::string_view line) {
+  size_t pos = 0;
+  std::string_view token1 = next_token(line, pos);
+  std::string_view token2 = next_token(line, pos);
+  int n = -1;
   // RINEX3: first token is a single uppercase letter (constellation)
   if (token1.size() == 1 && isupper(token1[0])) {
-    if (is_number(token2)) return std::stoi(token2);
+    if (is_number(token2) && to_int(token2, n)) return n;
     else return -1;
   }
   // RINEX2: first token should be the count
-  if (is_number(token1)) return std::stoi(token1);
+  if (is_number(token1) && to_int(token1, n)) return n;
   return -1;
 }
 
-bool parse_rinex_obs(const std::string &path, rinex::RinexObs &out) {
-  
-  // open the RINEX file for reading; return false if file canot be opened
-  std::ifstream f(path);
-  if (!f) return false;
-  
+// marks an unused sat_lookup_ slot
+static constexpr uint16_t kNoSat = 0xffff;
+
+int RinexObs::sat_index(SatId sv) const {
+  if (sat_lookup_.empty()) return -1;
+  uint16_t i = sat_lookup_[sv.index()];
+  return i == kNoSat ? -1 : (int)i;
+}
+
+std::vector<uint32_t> RinexObs::sat_rows(int sat_idx) const {
+  std::vector<uint32_t> rows;
+  for (size_t r = 0; r < row_sat.size(); ++r) {
+    if (row_sat[r] == sat_idx) rows.push_back((uint32_t)r);
+  }
+  return rows;
+}
+
+std::vector<uint32_t> RinexObs::flagged_rows(size_t type, uint8_t mask) const {
+  return rinex::flagged_rows(flags[type].data(), flags[type].size(), mask);
+}
+
+void RinexObs::reset_columns() {
+  epoch_time.clear();
+  epoch_flag.clear();
+  epoch_begin.clear();
+  sats.clear();
+  row_sat.clear();
+  sat_lookup_.assign(SatId::kIndexCount, kNoSat);
+  obs.clear();
+  obs_fixed.clear();
+  // the columns share the resource of obs
+  if (fixed_point) obs_fixed.resize(obs_types.size());
+  else obs.resize(obs_types.size());
+  flags.clear();
+  flags.resize(obs_types.size());
+}
+
+void RinexObs::reserve_rows(size_t rows) {
+  row_sat.reserve(row_sat.size() + rows);
+  for (auto& col : obs) col.reserve(col.size() + rows);
+  for (auto& col : obs_fixed) col.reserve(col.size() + rows);
+  for (auto& col : flags) col.reserve(col.size() + rows);
+}
+
+void RinexObs::index_sats() {
+  sat_lookup_.assign(SatId::kIndexCount, kNoSat);
+  for (size_t i = 0; i < sats.size(); ++i) sat_lookup_[sats[i].index()] = (uint16_t)i;
+}
+
+void RinexObs::append(const ObsEpoch& ep) {
+  epoch_time.push_back(ep.time);
+  epoch_flag.push_back((uint8_t)ep.event_flag);
+  epoch_begin.push_back((uint32_t)row_sat.size());
+
+  size_t cols = flags.size();
+  size_t n = std::min(ep.num_obs, cols);
+  if (sat_lookup_.empty()) sat_lookup_.assign(SatId::kIndexCount, kNoSat);
+  for (size_t i = 0; i < ep.sats.size(); ++i) {
+    uint16_t& idx = sat_lookup_[ep.sats[i].index()];
+    if (idx == kNoSat) {
+      idx = (uint16_t)sats.size();
+      sats.push_back(ep.sats[i]);
+    }
+    row_sat.push_back(idx);
+    if (fixed_point) {
+      for (size_t t = 0; t < n; ++t) {
+        obs_fixed[t].push_back(ep.fixed_point ? ep.sat_obs_fixed(i)[t] : to_fixed_point(ep.sat_obs(i)[t]));
+      }
+      for (size_t t = n; t < cols; ++t) obs_fixed[t].push_back(0);
+    } else {
+      for (size_t t = 0; t < n; ++t) obs[t].push_back(ep.value(i, t));
+      for (size_t t = n; t < cols; ++t) obs[t].push_back(0.0);
+    }
+    // an epoch assembled by hand may come without flags
+    const uint8_t* f = ep.flags.size() == ep.num_values() ? ep.sat_flags(i) : nullptr;
+    for (size_t t = 0; t < n; ++t) flags[t].push_back(f ? f[t] : 0);
+    for (size_t t = n; t < cols; ++t) flags[t].push_back(0);
+  }
+}
+
+void RinexObs::append(const RinexObs& other) {
+  if (sat_lookup_.empty()) sat_lookup_.assign(SatId::kIndexCount, kNoSat);
+  uint32_t row0 = (uint32_t)row_sat.size();
+  epoch_time.insert(epoch_time.end(), other.epoch_time.begin(), other.epoch_time.end());
+  epoch_flag.insert(epoch_flag.end(), other.epoch_flag.begin(), other.epoch_flag.end());
+  for (uint32_t b : other.epoch_begin) epoch_begin.push_back(row0 + b);
+
+  // other has its own satellite table; translate its indices into ours
+  std::vector<uint16_t> remap(other.sats.size());
+  for (size_t i = 0; i < other.sats.size(); ++i) {
+    uint16_t& idx = sat_lookup_[other.sats[i].index()];
+    if (idx == kNoSat) {
+      idx = (uint16_t)sats.size();
+      sats.push_back(other.sats[i]);
+    }
+    remap[i] = idx;
+  }
+  for (uint16_t s : other.row_sat) row_sat.push_back(remap[s]);
+  for (size_t t = 0; t < obs.size() && t < other.obs.size(); ++t) {
+    obs[t].insert(obs[t].end(), other.obs[t].begin(), other.obs[t].end());
+  }
+  for (size_t t = 0; t < obs_fixed.size() && t < other.obs_fixed.size(); ++t) {
+    obs_fixed[t].insert(obs_fixed[t].end(), other.obs_fixed[t].begin(), other.obs_fixed[t].end());
+  }
+  for (size_t t = 0; t < flags.size() && t < other.flags.size(); ++t) {
+    flags[t].insert(flags[t].end(), other.flags[t].begin(), other.flags[t].end());
+  }
+}
+
+void RinexObs::epoch(size_t e, ObsEpoch& ep) const {
+  ep.time = epoch_time[e];
+  ep.event_flag = epoch_flag[e];
+  ep.num_obs = flags.size();
+  ep.fixed_point = fixed_point;
+  ep.clear_sats();
+  for (size_t r = rows_begin(e); r < rows_end(e); ++r) {
+    ep.sats.push_back(sats[row_sat[r]]);
+    for (size_t t = 0; t < obs.size(); ++t) ep.obs.push_back(obs[t][r]);
+    for (size_t t = 0; t < obs_fixed.size(); ++t) ep.obs_fixed.push_back(obs_fixed[t][r]);
+    for (size_t t = 0; t < flags.size(); ++t) ep.flags.push_back(flags[t][r]);
+  }
+  ep.num_sv = (int)ep.sats.size();
+}
+
+// the data part of a header record; the label occupies columns 60-79
+static std::string_view header_data(std::string_view line) {
+  return line.substr(0, std::min<size_t>(line.size(), 60));
+}
+
+// append the obs types found in fld to obs_types, stopping at obs_type_count
+static void append_obs_types(const std::vector<std::string>& fld,
+                             std::vector<std::string>& obs_types,
+                             int obs_type_count) {
+  for (const std::string& t : fld) {
+    if (!t.empty()) obs_types.push_back(t);
+    if ((int)obs_types.size() == obs_type_count) break; // exit for loop if match
+  }
+}
+
+int RinexHeader::obs_type_index(std::string_view code) const {
+  for (size_t t = 0; t < obs_types.size(); ++t) {
+    if (obs_types[t] == code) return (int)t;
+  }
+  return -1;
+}
+
+// point every system's slots at their columns in obs_types; slots of other codes are dropped
+static void assign_obs_slots(RinexHeader& hdr) {
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    hdr.sys_slots[s].clear();
+    for (size_t j = 0; j < hdr.sys_obs_types[s].size(); ++j) {
+      int t = hdr.obs_type_index(hdr.sys_obs_types[s][j]);
+      if (t >= 0) hdr.sys_slots[s].push_back(ObsSlot{(uint16_t)j, (uint16_t)t});
+    }
+  }
+}
+
+ParseRinexError select_obs_types(rinex::RinexHeader& hdr, const std::vector<std::string>& codes) {
+  std::vector<std::string> selected;
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    for (const std::string& code : hdr.sys_obs_types[s]) {
+      bool wanted = codes.empty() || std::find(codes.begin(), codes.end(), code) != codes.end();
+      if (wanted && std::find(selected.begin(), selected.end(), code) == selected.end()) {
+        selected.push_back(code);
+      }
+    }
+  }
+  if (selected.empty()) return ParseRinexError::IncompatibleObsTypes;
+
+  // requested codes keep the caller's order
+  if (!codes.empty()) {
+    std::vector<std::string> ordered;
+    for (const std::string& code : codes) {
+      bool found = std::find(selected.begin(), selected.end(), code) != selected.end();
+      if (found && std::find(ordered.begin(), ordered.end(), code) == ordered.end()) {
+        ordered.push_back(code);
+      }
+    }
+    selected.swap(ordered);
+  }
+  hdr.obs_types.swap(selected);
+  assign_obs_slots(hdr);
+  return ParseRinexError::Success;
+}
+
+static ParseRinexError read_header(LineScanner& scanner, rinex::RinexHeader& hdr, ParseStats* stats) {
 
   // initialize state
   bool version_found = false, obs_type_line_found = false, eoh_found = false, is_v3 = false;
   
-  std::string line;
-  std::string version_line, obs_type_line;
+  std::string_view line;
   std::vector<std::string> obs_types;
+  std::vector<std::string> sys_obs_types[kNumSystems];
   int obs_type_count = 0;
 
-  // loop over the file 
-  while (std::getline(f, line)) {
-    line = rinex::trim(line);
-    
-    if (line.find("RINEX VERSION / TYPE") != std::string::npos) {
+  auto next_line = [&](std::string_view& l) {
+    if (!scanner.next(l)) return false;
+    if (stats) ++stats->header_lines;
+    return true;
+  };
+
+  // loop over the header; lines are not trimmed so that column offsets stay valid
+  while (next_line(line)) {
+    HeaderLabel label = header_label(line);
+    if (stats && label == HeaderLabel::Comment) ++stats->comment_lines;
+
+    if (label == HeaderLabel::VersionType) {
       version_found = true;
-      version_line = line;
       is_v3 = rinex::is_rinex_v3(line);
     }
 
-    // rinex v3
-    if (line.find("SYS / # / OBS TYPES") != std::string::npos) {
+    // rinex v3: one table per system, selected by the system letter in column 0
+    if (label == HeaderLabel::SysObsTypes) {
       obs_type_line_found = true;
-      obs_type_line = line;
-
-      char sys = line[0];
-      if (sys != 'G') continue; // only GPS for now
 
       obs_type_count = rinex::parse_obs_type_count(line);
-      if (obs_type_count <= 0) return false;
-
-      // stor obsercations types available in fld (field) vector
-      std::vector<std::string> fld = rinex::extract_obs_types_from_line(line, 7, 3, 4);
-      for (const std::string& t_raw : fld) {
-        std::string t = rinex::trim(t_raw); // obs type 
-        if (!t.empty()) obs_types.push_back(t);
-        if ((int)obs_types.size() == obs_type_count) break; // exit for loop if match
-      }
+      if (obs_type_count <= 0) return ParseRinexError::InvalidObsTypeCount;
+
+      // records of unknown systems are read like any other and then dropped
+      GnssSystem sys = line[0] == ' ' ? GnssSystem::Unknown : system_from_letter(line[0]);
+      std::vector<std::string>& types = sys_obs_types[(size_t)sys];
+      types.clear();
+
+      // store observation types available in fld (field) vector
+      append_obs_types(rinex::extract_obs_types_from_line(header_data(line), 7, 3, 4), types, obs_type_count);
+
       // if the number of listed types is less than the number of types reported in the file
-      //  try the next line
-      while ((int)obs_types.size() < obs_type_count) {
-        std::string l2; // the next line
-        if (!std::getline(f, l2)) break;
-        if (l2.find("SYS / # / OBS TYPES") == std::string::npos) break;
-        auto fld2 = rinex::extract_obs_types_from_line(l2, 0, 3, 4);
-        for (const std::string& t_raw : fld2) {
-          std::string t = rinex::trim(t_raw);
-          if (!t.empty()) obs_types.push_back(t);
-          if ((int)obs_types.size() == obs_type_count) break;
+      //  try the next line; a line that is not a continuation is left for the outer loop
+      while ((int)types.size() < obs_type_count) {
+        size_t mark = scanner.offset();
+        std::string_view l2; // the next line
+        if (!next_line(l2)) break;
+        if (header_label(l2) != HeaderLabel::SysObsTypes || l2[0] != ' ') {
+          scanner.seek(mark);
+          break;
         }
+        append_obs_types(rinex::extract_obs_types_from_line(header_data(l2), 7, 3, 4), types, obs_type_count);
       }
+      if ((int)types.size() != obs_type_count) return ParseRinexError::InvalidObsTypeCount;
+      continue;
     }
 
     // rinex v2
-    if (line.find("# / TYPES OF OBSERV") != std::string::npos) {
+    if (label == HeaderLabel::TypesOfObserv) {
       obs_type_line_found = true;
-      obs_type_line = line;
 
       obs_type_count = rinex::parse_obs_type_count(line);
-      if (obs_type_count <= 0) return false;
+      if (obs_type_count <= 0) return ParseRinexError::InvalidObsTypeCount;
+
+      append_obs_types(rinex::extract_obs_types_from_line(header_data(line), 6, 2, 3), obs_types, obs_type_count);
 
-      std::vector<std::string> fld = rinex::extract_obs_types_from_line(line, 6, 2, 3);
-      for (const std::string& t_raw : fld) {
-        std::string t = rinex::trim(t_raw);
-        if (!t.empty()) obs_types.push_back(t);
-        if ((int)obs_types.size() == obs_type_count) break;
-      }
       // same as above. Check next line for more observations.
       while ((int)obs_types.size() < obs_type_count) {
-        std::string l2; // next line 
-        if (!std::getline(f, l2)) break;
-        std::vector<std::string> fld2 = rinex::extract_obs_types_from_line(l2, 0, 2, 3);
-        for (const std::string& t_raw : fld2) {
-          std::string t = rinex::trim(t_raw);
-          if (!t.empty()) obs_types.push_back(t);
-          if ((int)obs_types.size() == obs_type_count) break;
-        }
+        std::string_view l2; // next line 
+        if (!next_line(l2)) break;
+        append_obs_types(rinex::extract_obs_types_from_line(header_data(l2), 6, 2, 3), obs_types, obs_type_count);
       }
+      if ((int)obs_types.size() != obs_type_count) return ParseRinexError::InvalidObsTypeCount;
+      continue;
     }
 
     // exit loop over header 
-    if (line.find("END OF HEADER") != std::string::npos) {
+    if (label == HeaderLabel::EndOfHeader) {
       eoh_found = true;
       break;
     }
   }
 
-  // if there were any problems parsing the header return false 
-  if (!eoh_found || 
-      !version_found || 
-      !obs_type_line_found || 
-       obs_type_count <= 0 || 
-       obs_types.size() != (size_t)obs_type_count
-      ) return false;
-  out.is_v3 = is_v3;
-  out.obs_types = obs_types;
-
-  // now parse epochs and observations
-  ObsEpoch current_epoch;
-  std::vector<std::string> sv_ids;
-  
-  // initialize the state 
-  int svs_remaining = 0, obs_lines_remaining = 0;
-  bool in_epoch = false;
+  // if there were any problems parsing the header return an error
+  if (!eoh_found || !version_found || !obs_type_line_found) return ParseRinexError::MissingHeader;
+  hdr.is_v3 = is_v3;
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    if (is_v3) {
+      hdr.sys_obs_types[s] = (s == (size_t)GnssSystem::Unknown) ? std::vector<std::string>() : sys_obs_types[s];
+    } else {
+      hdr.sys_obs_types[s] = obs_types; // RINEX 2 types apply to every system
+    }
+  }
+  if (select_obs_types(hdr, {}) != ParseRinexError::Success) return ParseRinexError::InvalidObsTypeCount;
+  return ParseRinexError::Success;
+}
 
-  // loop over the remaning lines in the file
-  while (std::getline(f, line)) {
-    line = rinex::trim(line);
-    if (line.empty()) continue;
 
-    // rinex v3
-    if (is_v3) {
+ParseRinexError parse_rinex_header(LineScanner& scanner, rinex::RinexHeader& hdr, ParseStats* stats) {
+  if (!stats) return read_header(scanner, hdr, nullptr);
+  int64_t t0 = stats_clock_ns();
+  uint64_t lines0 = stats->header_lines;
+  ParseRinexError err = read_header(scanner, hdr, stats);
+  stats->lines += stats->header_lines - lines0;
+  stats->header_ns += stats_clock_ns() - t0;
+  return err;
+}
 
-      // if current line is an epoch header line 
-      if (line[0] == '>') { 
-        std::istringstream iss(line.substr(1));
-        int year, month, day, hour, minute, event_flag, num_sv;
-        double second;
-        iss >> year >> month >> day >> hour >> minute >> second >> event_flag >> num_sv;
-        if (iss.fail()) continue;
-
-        // these current epoch data are only set if the epoch header was successfully parsed
-        current_epoch = ObsEpoch{};
-        current_epoch.year = year;
-        current_epoch.month = month;
-        current_epoch.day = day;
-        current_epoch.hour = hour;
-        current_epoch.minute = minute;
-        current_epoch.second = second;
-        current_epoch.event_flag = event_flag;
-        current_epoch.num_sv = num_sv;
-        svs_remaining = num_sv;
-        in_epoch = true;
-        continue;
-      }
-      if (in_epoch && svs_remaining > 0) { // if epoch header parsing fails svs_remaining=0
-        std::istringstream sat_iss(line);
-
-        std::string sv_id;
-        sat_iss >> sv_id; // read the sv id, which is the first space delimited token
-        sv_id = rinex::normalize_sat_id(sv_id); // impose rinex v3 naming convention 
-
-        std::vector<double> obs_values;
-        for (size_t j = 0; j < out.obs_types.size(); ++j) {
-          double val = 0.0;
-          sat_iss >> val;
-          obs_values.push_back(val);
-        }
-        double l1 = obs_values.size() > 0 ? obs_values[0] : 0.0; // L1
-        double l2 = obs_values.size() > 1 ? obs_values[1] : 0.0; // L2
-        current_epoch.sat_L1L2[sv_id] = std::make_pair(l1, l2);
-
-        svs_remaining--;
-        if (svs_remaining == 0) {
-          out.epochs.push_back(current_epoch);
-          in_epoch = false;
-        }
-        continue;
-      }
-    } else {
-      
-      // rinex v2 
-      int year, month, day, hour, minute, num_sv;
-      double second;
-      int event_flag = 0;
-
-      std::istringstream iss(line);
-      if (iss >> year >> month >> day >> hour >> minute >> second >> event_flag >> num_sv) {
-        current_epoch = ObsEpoch{};
-        current_epoch.year = year;
-        current_epoch.month = month;
-        current_epoch.day = day;
-        current_epoch.hour = hour;
-        current_epoch.minute = minute;
-        current_epoch.second = second;
-        current_epoch.num_sv = num_sv;
-        current_epoch.event_flag = event_flag;
-        sv_ids.clear();
-        std::string token;
-        while (iss >> token) sv_ids.push_back(token);
-        while ((int)sv_ids.size() < num_sv) {
-          if (!std::getline(f, line)) break;
-          line = rinex::trim(line);
-          std::istringstream sv_iss(line);
-          while (sv_iss >> token) sv_ids.push_back(token);
-        }
-        obs_lines_remaining = num_sv;
-        in_epoch = true;
-        continue;
-      }
-      if (in_epoch && obs_lines_remaining > 0) { // if epoch header parsing fails svs_remaining=0
-        std::istringstream sat_iss(line);
-        std::vector<double> obs_values;
-        for (size_t j = 0; j < out.obs_types.size(); ++j) {
-          double val = 0.0;
-          sat_iss >> val;
-          obs_values.push_back(val);
-        }
-        double l1 = obs_values.size() > 0 ? obs_values[0] : 0.0; // L1
-        double l2 = obs_values.size() > 1 ? obs_values[1] : 0.0; // L2
-
-        std::string sv_id = rinex::normalize_sat_id(sv_ids[sv_ids.size() - obs_lines_remaining]);
-        current_epoch.sat_L1L2[sv_id] = std::make_pair(l1, l2);
-        
-        obs_lines_remaining--;
-        if (obs_lines_remaining == 0) {
-          out.epochs.push_back(current_epoch);
-          in_epoch = false;
-        }
-        continue;
-      }
+// Expected satellite rows in body bytes of observation records, from the mean record
+// length of the systems in the header. Epoch records make it a slight overestimate.
+static size_t estimate_rows(size_t body_bytes, const RinexHeader& hdr) {
+  size_t tables = 0, slots = 0;
+  for (size_t s = 0; s < kNumSystems; ++s) {
+    if (hdr.sys_slots[s].empty()) continue;
+    ++tables;
+    slots += hdr.sys_obs_types[s].size();
+  }
+  if (tables == 0) return 0;
+  size_t n = (slots + tables - 1) / tables;
+  // RINEX 3: satellite id, slots and newline; RINEX 2: five slots per line
+  size_t row_bytes = hdr.is_v3 ? 3 + 16 * n + 1 : 16 * n + (n + 4) / 5;
+  return body_bytes / std::max<size_t>(row_bytes, 1);
+}
+
+ParseRinexError parse_rinex_obs(const std::string &path, rinex::RinexObs &out) {
+  return parse_rinex_obs(path, out, ParseOptions());
+}
+
+// capacities of the arrays of a RinexObs, to count their growth for ParseStats
+struct ObsCapacity {
+  size_t epochs, rows, sats;
+};
+
+static ObsCapacity obs_capacity(const RinexObs& obs) {
+  return {obs.epoch_time.capacity(), obs.row_sat.capacity(), obs.sats.capacity()};
+}
+
+// arrays of obs reallocated since before; the per-epoch and the per-row arrays grow together
+static uint64_t grown_arrays(const ObsCapacity& before, const RinexObs& obs) {
+  ObsCapacity now = obs_capacity(obs);
+  return (now.epochs != before.epochs ? 3 : 0) +
+         (now.rows != before.rows ? 1 + 2 * obs.flags.size() : 0) +
+         (now.sats != before.sats ? 1 : 0);
+}
+
+// decode all epochs of reader into out; with stats, the appends are timed and counted too
+static void decode_into(EpochReader& reader, RinexObs& out, ParseStats* stats) {
+  ObsEpoch epoch;
+  if (!stats) {
+    while (reader.next(epoch)) out.append(epoch);
+    return;
+  }
+  while (reader.next(epoch)) {
+    int64_t t0 = stats_clock_ns();
+    ObsCapacity cap = obs_capacity(out);
+    out.append(epoch);
+    stats->allocations += grown_arrays(cap, out);
+    stats->assemble_ns += stats_clock_ns() - t0;
+  }
+}
+
+static ParseRinexError parse_obs(const std::string& path, RinexObs& out, const ParseOptions& opts) {
+  ParseStats* stats = opts.stats;
+  // input read ahead on the I/O thread is never mapped; EpochReader sniffs its format
+  // from the stream
+  bool stream = opts.io_thread || opts.async_io;
+  MappedFile file;
+  if (!stream) {
+    if (!file.open(path)) return ParseRinexError::FileNotFound;
+    if (stats) stats->bytes += file.size();
+    stream = detect_input_format(file.view().substr(0, 256)) != InputFormat::Plain;
+  } else if (stats) {
+    uint64_t size;
+    int64_t mtime;
+    if (file_stamp(path, size, mtime)) stats->bytes += size;
+  }
+
+  // encoded input cannot be cut into chunks; decode it (and read ahead input) as one
+  // stream
+  if (stream) {
+    file.close();
+    EpochReader reader;
+    reader.set_stats(stats);
+    ParseRinexError err = reader.open(path, opts.io_thread, opts.async_io);
+    if (err == ParseRinexError::Success && !opts.obs_codes.empty()) {
+      err = reader.select_obs_types(opts.obs_codes);
     }
+    if (err != ParseRinexError::Success) return err;
+    reader.set_fixed_point(opts.fixed_point);
+    static_cast<RinexHeader&>(out) = reader.header();
+    out.reset_columns();
+    decode_into(reader, out, stats);
+    if (stats) stats->text_bytes += reader.offset();
+    if (out.num_epochs() == 0) return ParseRinexError::NoEpochs;
+    return ParseRinexError::Success;
+  }
+
+  if (stats) stats->text_bytes += file.size();
+  LineScanner scanner(file.view());
+  RinexHeader hdr;
+  ParseRinexError err = parse_rinex_header(scanner, hdr, stats);
+  if (err == ParseRinexError::Success && !opts.obs_codes.empty()) {
+    err = select_obs_types(hdr, opts.obs_codes);
+  }
+  if (err != ParseRinexError::Success) return err;
+  hdr.fixed_point = opts.fixed_point;
+  static_cast<RinexHeader&>(out) = hdr;
+  out.reset_columns();
+
+  // the observation records, everything after END OF HEADER
+  std::string_view body = file.view().substr(scanner.offset());
+
+  size_t threads = opts.pool ? opts.pool->size()
+                             : (opts.threads ? opts.threads : std::thread::hardware_concurrency());
+  size_t max_chunks = body.size() / std::max<size_t>(opts.min_chunk_bytes, 1);
+  size_t nchunks = std::max<size_t>(1, std::min(threads, max_chunks));
+
+  // cut the body at epoch records near nchunks equally spaced offsets
+  std::vector<size_t> bounds(nchunks + 1, body.size());
+  bounds[0] = 0;
+  for (size_t i = 1; i < nchunks; ++i) {
+    bounds[i] = std::max(bounds[i - 1], find_epoch_start(body, i * (body.size() / nchunks), hdr.is_v3));
   }
-  if (out.epochs.empty()) return false;
-  return true;
+
+  // decode one chunk into part, reusing one epoch buffer for the whole chunk
+  auto decode_chunk = [&](size_t i, RinexObs& part, ParseStats* chunk_stats) {
+    EpochReader reader;
+    reader.open(body.substr(bounds[i], bounds[i + 1] - bounds[i]), hdr);
+    reader.set_stats(chunk_stats);
+    decode_into(reader, part, chunk_stats);
+  };
+
+  if (nchunks == 1) {
+    out.reserve_rows(estimate_rows(body.size(), hdr));
+    decode_chunk(0, out, stats);
+  } else {
+    // each chunk grows in an arena of its own, dropped in one go once it is merged
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas;
+    std::vector<RinexObs> parts;
+    parts.reserve(nchunks);
+    for (size_t i = 0; i < nchunks; ++i) {
+      arenas.emplace_back(new std::pmr::monotonic_buffer_resource());
+      parts.emplace_back(arenas.back().get());
+      RinexObs& part = parts.back();
+      static_cast<RinexHeader&>(part) = hdr;
+      part.reset_columns();
+      part.reserve_rows(estimate_rows(bounds[i + 1] - bounds[i], hdr));
+    }
+    // the calling thread takes part in wait(), so a pool of our own needs one less
+    std::unique_ptr<ThreadPool> own_pool;
+    ThreadPool* pool = opts.pool;
+    if (!pool) {
+      own_pool.reset(new ThreadPool((unsigned)(nchunks - 1)));
+      pool = own_pool.get();
+    }
+    // each chunk counts into stats of its own, added up once all are done
+    std::vector<ParseStats> chunk_stats(stats ? nchunks : 0);
+    ThreadPool::TaskGroup group;
+    for (size_t i = 0; i < nchunks; ++i) {
+      pool->submit(group, [&, i]() { decode_chunk(i, parts[i], stats ? &chunk_stats[i] : nullptr); });
+    }
+    pool->wait(group);
+    for (const ParseStats& s : chunk_stats) stats->merge(s);
+
+    // chunks are in file order, so concatenating them keeps epochs in time order
+    int64_t t0 = stats ? stats_clock_ns() : 0;
+    ObsCapacity cap = obs_capacity(out);
+    size_t rows = 0;
+    for (const RinexObs& part : parts) rows += part.num_rows();
+    out.reserve_rows(rows);
+    for (const RinexObs& part : parts) out.append(part);
+    if (stats) {
+      stats->allocations += grown_arrays(cap, out);
+      stats->assemble_ns += stats_clock_ns() - t0;
+    }
+  }
+
+  if (out.num_epochs() == 0) return ParseRinexError::NoEpochs;
+  return ParseRinexError::Success;
+}
+ParseRinexError parse_rinex_obs(const std::string &path, rinex::RinexObs &out,
+                                const ParseOptions &opts) {
+  if (!opts.stats) return parse_obs(path, out, opts);
+  int64_t t0 = stats_clock_ns();
+  ParseRinexError err = parse_obs(path, out, opts);
+  ++opts.stats->files;
+  opts.stats->total_ns += stats_clock_ns() - t0;
+  return err;
 }
+
 } // end namespace rinex
\ No newline at end of file
@@ -0,0 +1,63 @@
+// File:   ParseStats.cpp
+// Description:
+// Parser counters and stage timers, and their JSON form.
+//
+
+#include "../include/ParseStats.hpp"
+
+namespace rinex {
+
+// every field with its JSON key, in output order
+static const struct {
+  const char* name;
+  uint64_t ParseStats::*field;
+} kCounters[] = {
+    {"files", &ParseStats::files},
+    {"bytes", &ParseStats::bytes},
+    {"text_bytes", &ParseStats::text_bytes},
+    {"lines", &ParseStats::lines},
+    {"header_lines", &ParseStats::header_lines},
+    {"comment_lines", &ParseStats::comment_lines},
+    {"epochs", &ParseStats::epochs},
+    {"event_records", &ParseStats::event_records},
+    {"dropped_epochs", &ParseStats::dropped_epochs},
+    {"stray_lines", &ParseStats::stray_lines},
+    {"satellites", &ParseStats::satellites},
+    {"skipped_satellites", &ParseStats::skipped_satellites},
+    {"fields_decoded", &ParseStats::fields_decoded},
+    {"fields_skipped", &ParseStats::fields_skipped},
+    {"allocations", &ParseStats::allocations},
+};
+
+static const struct {
+  const char* name;
+  int64_t ParseStats::*field;
+} kTimers[] = {
+    {"header_ns", &ParseStats::header_ns},
+    {"epoch_ns", &ParseStats::epoch_ns},
+    {"obs_ns", &ParseStats::obs_ns},
+    {"assemble_ns", &ParseStats::assemble_ns},
+    {"total_ns", &ParseStats::total_ns},
+};
+
+void ParseStats::merge(const ParseStats& other) {
+  for (const auto& c : kCounters) this->*c.field += other.*c.field;
+  for (const auto& t : kTimers) this->*t.field += other.*t.field;
+}
+
+std::string ParseStats::to_json() const {
+  std::string json = "{";
+  auto add = [&](const char* name, const std::string& value) {
+    if (json.size() > 1) json += ',';
+    json += '"';
+    json += name;
+    json += "\":";
+    json += value;
+  };
+  for (const auto& c : kCounters) add(c.name, std::to_string(this->*c.field));
+  for (const auto& t : kTimers) add(t.name, std::to_string(this->*t.field));
+  json += '}';
+  return json;
+}
+
+} // end namespace rinex
@@ -0,0 +1,259 @@
+// File:   RinexFollower.cpp
+// Description:
+// Incremental decoding of RINEX observation files that are still being written.
+//
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "../include/RinexFollower.hpp"
+#include "../include/ByteSource.hpp"
+#include "../include/EpochReader.hpp"
+#include "../include/LineScan.hpp"
+#include "../include/ParseStats.hpp"
+
+namespace rinex {
+
+static constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+
+// 64-bit FNV-1a of the bytes read so far, to tell an overwritten file from a touched one
+static uint64_t fnv1a(uint64_t hash, const char* p, size_t n) {
+  for (size_t i = 0; i < n; ++i) hash = (hash ^ (unsigned char)p[i]) * 1099511628211ull;
+  return hash;
+}
+
+ParseRinexError RinexFollower::open(const std::string& path, const ParseOptions& opts) {
+  close();
+  if (!open_file(path)) return ParseRinexError::FileNotFound;
+  path_ = path;
+  opts_ = opts;
+  if (opts_.stats) ++opts_.stats->files;
+  restart();
+  return ParseRinexError::Success;
+}
+
+bool RinexFollower::open_file(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  if (fd_ >= 0) ::close(fd_);
+  if (notify_fd_ >= 0) ::close(notify_fd_);
+  fd_ = fd;
+  notify_fd_ = -1;
+#ifdef __linux__
+  // without a watch, wait() falls back to polling the file size; IN_ATTRIB comes with
+  // the unlink of a file replaced by a rename
+  notify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (notify_fd_ >= 0 &&
+      inotify_add_watch(notify_fd_, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF) < 0) {
+    ::close(notify_fd_);
+    notify_fd_ = -1;
+  }
+#endif
+  return true;
+}
+
+void RinexFollower::close() {
+  if (fd_ >= 0) ::close(fd_);
+  if (notify_fd_ >= 0) ::close(notify_fd_);
+  fd_ = notify_fd_ = -1;
+  restart();
+  epochs_ = 0;
+}
+
+void RinexFollower::restart() {
+  header_ = RinexHeader();
+  header_ready_ = false;
+  consumed_ = 0;
+  pending_.clear();
+  tail_.clear();
+  read_hash_ = kFnvOffset;
+  read_mtime_ = 0;
+  unchanged_mtime_ = 0;
+}
+
+bool RinexFollower::replaced() const {
+  struct stat named, opened;
+  return stat(path_.c_str(), &named) == 0 && fstat(fd_, &opened) == 0 &&
+         (named.st_ino != opened.st_ino || named.st_dev != opened.st_dev);
+}
+
+bool RinexFollower::rewritten(uint64_t size, int64_t mtime) {
+  uint64_t pos = consumed_ + pending_.size();
+  if (size < pos) return true;
+  if (tail_.empty()) return false;
+  char buf[kTailBytes];
+  ssize_t r = pread(fd_, buf, tail_.size(), (off_t)(pos - tail_.size()));
+  if (r != (ssize_t)tail_.size() || memcmp(buf, tail_.data(), tail_.size()) != 0) return true;
+
+  // Modified without growing: either the size of an append is not visible yet, and the
+  // next poll sees the file grow, or it was overwritten with as many bytes. Only a file
+  // that stays so until the next poll is hashed again, once per change, as that reads
+  // all of it.
+  if (size != pos || mtime == read_mtime_) return false;
+  if (mtime != unchanged_mtime_) {
+    unchanged_mtime_ = mtime;
+    return false;
+  }
+  std::string block(1 << 16, '\0');
+  uint64_t hash = kFnvOffset;
+  for (uint64_t at = 0; at < pos;) {
+    ssize_t n = pread(fd_, &block[0], (size_t)std::min<uint64_t>(block.size(), pos - at), (off_t)at);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return true;
+    hash = fnv1a(hash, block.data(), (size_t)n);
+    at += (uint64_t)n;
+  }
+  read_mtime_ = mtime;
+  return hash != read_hash_;
+}
+
+uint64_t RinexFollower::file_size() const {
+  uint64_t size;
+  int64_t mtime;
+  return file_stat(size, mtime) ? size : 0;
+}
+
+bool RinexFollower::file_stat(uint64_t& size, int64_t& mtime) const {
+  struct stat st;
+  if (fd_ < 0 || fstat(fd_, &st) != 0) return false;
+  size = (uint64_t)st.st_size;
+  mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+ParseRinexError RinexFollower::poll(const EpochCallback& fn) {
+  if (fd_ < 0) return ParseRinexError::FileNotFound;
+  if (!opts_.stats) return poll_file(fn);
+  int64_t t0 = stats_clock_ns();
+  ParseRinexError err = poll_file(fn);
+  opts_.stats->total_ns += stats_clock_ns() - t0;
+  return err;
+}
+
+ParseRinexError RinexFollower::poll_file(const EpochCallback& fn) {
+  // A file replaced at path, or one that no longer has the bytes that were read, has
+  // been rewritten. Start over, and tell the caller before its epochs come again.
+  bool reopened = replaced() && open_file(path_);
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  file_stat(size, mtime);
+  if (reopened || rewritten(size, mtime)) {
+    bool read_any = consumed_ + pending_.size() > 0;
+    restart();
+    if (read_any) return ParseRinexError::Restarted;
+  }
+
+  // read the appended bytes
+  uint64_t pos = consumed_ + pending_.size();
+  size_t before = pending_.size();
+  while (pos < size) {
+    size_t old = pending_.size();
+    pending_.resize(old + (size_t)(size - pos));
+    ssize_t r = pread(fd_, &pending_[old], (size_t)(size - pos), (off_t)pos);
+    if (r < 0 && errno == EINTR) r = 0;
+    if (r <= 0) {
+      pending_.resize(old);
+      break;
+    }
+    pending_.resize(old + (size_t)r);
+    pos += (uint64_t)r;
+    if (opts_.stats) {
+      opts_.stats->bytes += (uint64_t)r;
+      opts_.stats->text_bytes += (uint64_t)r;
+    }
+  }
+  size_t added = pending_.size() - before;
+  if (added > 0) {
+    read_hash_ = fnv1a(read_hash_, pending_.data() + before, added);
+    read_mtime_ = mtime;
+    size_t k = std::min(added, kTailBytes);
+    tail_.append(pending_, pending_.size() - k, k);
+    if (tail_.size() > kTailBytes) tail_.erase(0, tail_.size() - kTailBytes);
+  }
+
+  // decode complete lines only; a line being written stays pending
+  size_t nl = pending_.rfind('\n');
+  if (nl == std::string::npos) return ParseRinexError::Success;
+  std::string_view text(pending_.data(), nl + 1);
+
+  if (!header_ready_) {
+    if (consumed_ == 0 && detect_input_format(text.substr(0, 256)) != InputFormat::Plain) {
+      return ParseRinexError::UnsupportedFormat;
+    }
+    // wait for END OF HEADER before parsing, so that only a complete header can fail
+    LineScanner probe(text);
+    std::string_view line;
+    bool complete = false;
+    while (!complete && probe.next(line)) complete = header_label(line) == HeaderLabel::EndOfHeader;
+    if (!complete) return ParseRinexError::Success;
+
+    LineScanner scanner(text);
+    ParseRinexError err = parse_rinex_header(scanner, header_, opts_.stats);
+    if (err == ParseRinexError::Success && !opts_.obs_codes.empty()) {
+      err = select_obs_types(header_, opts_.obs_codes);
+    }
+    if (err != ParseRinexError::Success) return err;
+    header_.fixed_point = opts_.fixed_point;
+    header_ready_ = true;
+    size_t end = scanner.offset();
+    pending_.erase(0, end);
+    consumed_ += end;
+    text = std::string_view(pending_.data(), nl + 1 - end);
+  }
+
+  // Emit the complete epochs; the offset after the last one is where the next poll
+  // resumes. The reader counts into scratch, and only the counts up to that offset are
+  // kept, so the text after it is counted once, by the poll that consumes it.
+  ParseStats scratch, counted;
+  EpochReader reader;
+  reader.open(text, header_);
+  if (opts_.stats) reader.set_stats(&scratch);
+  size_t end = 0;
+  while (reader.next(epoch_)) {
+    end = reader.offset();
+    ++epochs_;
+    if (opts_.stats) counted = scratch;
+    fn(epoch_);
+  }
+  if (opts_.stats) opts_.stats->merge(counted);
+  pending_.erase(0, end);
+  consumed_ += end;
+  return ParseRinexError::Success;
+}
+
+bool RinexFollower::wait(int timeout_ms) {
+  if (fd_ < 0) return false;
+  if (file_size() != consumed_ + pending_.size() || replaced()) return true;
+#ifdef __linux__
+  if (notify_fd_ >= 0) {
+    struct pollfd p = {notify_fd_, POLLIN, 0};
+    int r = ::poll(&p, 1, timeout_ms);
+    if (r <= 0) return false;
+    char events[4096];
+    while (read(notify_fd_, events, sizeof(events)) > 0) {} // drain; only the wake-up matters
+    return true;
+  }
+#endif
+  // no notifications: check the size every 50 ms
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto step = std::min<std::chrono::steady_clock::duration>(std::chrono::milliseconds(50),
+                                                              deadline - std::chrono::steady_clock::now());
+    std::this_thread::sleep_for(step);
+    if (file_size() != consumed_ + pending_.size() || replaced()) return true;
+  }
+  return false;
+}
+
+} // end namespace rinex
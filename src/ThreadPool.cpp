@@ -0,0 +1,135 @@
+// File:   ThreadPool.cpp
+// Description:
+// Work-stealing thread pool shared by the chunked and the batch parsers.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "../include/ThreadPool.hpp"
+
+namespace rinex {
+
+// pool and queue of the worker running on this thread, if any
+static thread_local const ThreadPool* tls_pool = nullptr;
+static thread_local size_t tls_queue = 0;
+
+ThreadPool::ThreadPool(unsigned threads) {
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned i = 0; i < threads; ++i) queues_.emplace_back(new Queue());
+  for (unsigned i = 0; i < threads; ++i) workers_.emplace_back([this, i]() { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (std::thread& t : workers_) t.join();
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> fn) {
+  group.pending_.fetch_add(1, std::memory_order_relaxed);
+  group.queued_.fetch_add(1, std::memory_order_release);
+  size_t q = (tls_pool == this) ? tls_queue : next_queue_++ % queues_.size();
+  {
+    std::lock_guard<std::mutex> lock(queues_[q]->m);
+    queues_[q]->tasks.push_back(Task{std::move(fn), &group});
+  }
+  queued_.fetch_add(1, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(m_); // pairs with the predicate check of sleeping workers
+  }
+  work_cv_.notify_one();
+}
+
+// own queue from the back, then the other queues from the front
+bool ThreadPool::pop(size_t self, Task& task) {
+  if (queued_.load(std::memory_order_acquire) == 0) return false;
+  size_t n = queues_.size();
+  for (size_t k = 0; k < n; ++k) {
+    Queue& q = *queues_[(self + k) % n];
+    std::lock_guard<std::mutex> lock(q.m);
+    if (q.tasks.empty()) continue;
+    if (k == 0) {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    task.group->queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+// same order, but only tasks of group
+bool ThreadPool::pop_group(size_t self, const TaskGroup& group, Task& task) {
+  if (group.queued_.load(std::memory_order_acquire) == 0) return false;
+  size_t n = queues_.size();
+  for (size_t k = 0; k < n; ++k) {
+    Queue& q = *queues_[(self + k) % n];
+    std::lock_guard<std::mutex> lock(q.m);
+    auto match = [&](const Task& t) { return t.group == &group; };
+    auto it = q.tasks.end();
+    if (k == 0) {
+      auto r = std::find_if(q.tasks.rbegin(), q.tasks.rend(), match);
+      if (r != q.tasks.rend()) it = std::prev(r.base());
+    } else {
+      it = std::find_if(q.tasks.begin(), q.tasks.end(), match);
+    }
+    if (it == q.tasks.end()) continue;
+    task = std::move(*it);
+    q.tasks.erase(it);
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    task.group->queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::run(Task& task) {
+  task.fn();
+  task.fn = nullptr;
+  if (task.group->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard<std::mutex> lock(m_);
+    done_cv_.notify_all();
+  }
+}
+
+void ThreadPool::worker_loop(size_t self) {
+  tls_pool = this;
+  tls_queue = self;
+  Task task;
+  while (true) {
+    if (pop(self, task)) {
+      run(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_);
+    work_cv_.wait(lock, [this]() { return stop_ || queued_.load(std::memory_order_acquire) > 0; });
+    if (stop_ && queued_.load(std::memory_order_acquire) == 0) return;
+  }
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+  size_t self = (tls_pool == this) ? tls_queue : 0;
+  Task task;
+  while (!group.done()) {
+    if (pop_group(self, group, task)) {
+      run(task);
+      continue;
+    }
+    // the remaining tasks of group are running elsewhere
+    std::unique_lock<std::mutex> lock(m_);
+    done_cv_.wait_for(lock, std::chrono::milliseconds(1), [&]() {
+      return group.done() || group.queued_.load(std::memory_order_acquire) > 0;
+    });
+  }
+}
+
+} // end namespace rinex
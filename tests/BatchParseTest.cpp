@@ -0,0 +1,104 @@
+// BatchParseTest.cpp
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/AsyncReader.hpp"
+#include "../include/BatchParse.hpp"
+#include "../include/ThreadPool.hpp"
+#include "RinexGenerator.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+TEST(ThreadPool, NestedGroups) {
+  ThreadPool pool(3);
+  EXPECT_EQ(pool.size(), 3u);
+  std::atomic<int> sum{0};
+  ThreadPool::TaskGroup outer;
+  for (int i = 0; i < 8; ++i) {
+    pool.submit(outer, [&pool, &sum, i] {
+      // tasks may split themselves and wait on the parts
+      ThreadPool::TaskGroup inner;
+      for (int j = 0; j < 10; ++j) pool.submit(inner, [&sum, i, j] { sum += i * 10 + j; });
+      pool.wait(inner);
+      EXPECT_TRUE(inner.done());
+    });
+  }
+  pool.wait(outer);
+  EXPECT_TRUE(outer.done());
+  EXPECT_EQ(sum.load(), 79 * 80 / 2);
+}
+
+TEST(ThreadPool, WaitRunsOnlyItsGroup) {
+  ThreadPool pool(1);
+  std::atomic<bool> started{false}, release{false};
+  ThreadPool::TaskGroup busy, mine, other;
+  pool.submit(busy, [&] {
+    started = true;
+    while (!release) std::this_thread::yield();
+  });
+  while (!started) std::this_thread::yield();
+  // the worker is busy, so both stay queued, other's task on top
+  bool ran_mine = false, ran_other = false;
+  pool.submit(mine, [&] { ran_mine = true; });
+  pool.submit(other, [&] { ran_other = true; });
+  pool.wait(mine);
+  EXPECT_TRUE(ran_mine);
+  EXPECT_FALSE(ran_other);
+  release = true;
+  pool.wait(other);
+  pool.wait(busy);
+  EXPECT_TRUE(ran_other);
+}
+
+TEST(BatchParse, MatchesSingleParses) {
+  std::vector<std::string> paths = {test::data_path("obs_v3.rnx"), test::data_path("no_such_file.rnx")};
+  for (int i = 0; i < 4; ++i) {
+    bench::GeneratorOptions g;
+    g.version = 2 + i % 2;
+    g.interval = 1.0;
+    g.duration = 200 + 300 * i;
+    g.seed = i + 1;
+    paths.push_back(test::temp_path("gen" + std::to_string(i) + ".rnx"));
+    bench::write_rinex(paths.back(), g);
+  }
+  paths.push_back(test::data_path("obs_v2.rnx"));
+
+  AsyncReader io(8, 64 << 10, 2);
+  for (bool async : {false, true}) {
+    ParseOptions opts;
+    opts.threads = 3;
+    opts.min_chunk_bytes = 64 << 10;
+    if (async) opts.async_io = &io;
+    std::vector<BatchResult> results = parse_rinex_batch(paths, opts);
+    ASSERT_EQ(results.size(), paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+      EXPECT_EQ(results[i].path, paths[i]);
+      RinexObs obs;
+      ParseRinexError err = parse_rinex_obs(paths[i], obs);
+      ASSERT_EQ(results[i].error, err) << paths[i];
+      if (err == ParseRinexError::Success) test::expect_same_obs(results[i].obs, obs);
+    }
+  }
+}
+
+TEST(BatchParse, SinkCallsAreSerialized) {
+  std::vector<std::string> paths(12, test::data_path("obs_v2.rnx"));
+  ThreadPool pool(4);
+  ParseOptions opts;
+  opts.pool = &pool;
+  std::vector<int> seen(paths.size(), 0);
+  int in_sink = 0;
+  parse_rinex_batch(paths, [&](size_t index, const std::string&, ParseRinexError error, RinexObs& obs) {
+    EXPECT_EQ(++in_sink, 1);
+    EXPECT_EQ(error, ParseRinexError::Success);
+    EXPECT_EQ(obs.num_epochs(), 2u);
+    ++seen[index];
+    --in_sink;
+  }, opts);
+  EXPECT_EQ(seen, std::vector<int>(paths.size(), 1));
+}
@@ -0,0 +1,118 @@
+// ByteSourceTest.cpp
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/AsyncReader.hpp"
+#include "../include/ByteSource.hpp"
+#include "../include/SpscQueue.hpp"
+#include "RinexGenerator.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+std::string read_all(ByteSource& src, size_t step = 1000) {
+  std::string out, buf(step, '\0');
+  while (size_t n = src.read(&buf[0], buf.size())) out.append(buf, 0, n);
+  EXPECT_FALSE(src.failed());
+  return out;
+}
+
+std::string generated_file() {
+  bench::GeneratorOptions g;
+  g.interval = 1.0;
+  g.duration = 300;
+  std::string path = test::temp_path("generated.rnx");
+  bench::write_rinex(path, g);
+  return path;
+}
+
+} // end namespace
+
+TEST(SpscQueue, KeepsOrderAcrossThreads) {
+  SpscQueue<int> q(5);
+  EXPECT_EQ(q.capacity(), 8u);
+  const int n = 100000;
+  std::thread producer([&] {
+    for (int i = 0; i < n; ++i) {
+      while (!q.try_push(i)) std::this_thread::yield();
+    }
+  });
+  int v = 0;
+  for (int i = 0; i < n; ++i) {
+    while (!q.try_pop(v)) std::this_thread::yield();
+    ASSERT_EQ(v, i);
+  }
+  producer.join();
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(ByteSource, DetectsInputFormat) {
+  EXPECT_EQ(detect_input_format("     3.04           OBSERVATION DATA"), InputFormat::Plain);
+  EXPECT_EQ(detect_input_format(std::string("\x1f\x8b\x08", 3)), InputFormat::Gzip);
+  EXPECT_EQ(detect_input_format(std::string("\x1f\x9d\x90", 3)), InputFormat::Compress);
+  EXPECT_EQ(detect_input_format("1.0                 COMPACT RINEX FORMAT                    CRINEX VERS   / TYPE"),
+            InputFormat::Hatanaka);
+  EXPECT_EQ(detect_input_format(""), InputFormat::Plain);
+}
+
+TEST(ByteSource, PrefixedSource) {
+  std::string path = test::data_path("obs_v2.rnx");
+  std::string text = test::read_file(path);
+  PrefixedSource src("prefix\n", std::unique_ptr<ByteSource>(new FileSource(path)));
+  EXPECT_EQ(read_all(src, 3), "prefix\n" + text);
+}
+
+TEST(ByteSource, ThreadedSourceReadsEveryByte) {
+  std::string path = generated_file();
+  std::string text = test::read_file(path);
+  for (size_t buffer_size : {4096, 100000, 1 << 20}) {
+    ThreadedSource src(std::unique_ptr<ByteSource>(new FileSource(path)), buffer_size, 2);
+    EXPECT_EQ(read_all(src, 7777), text) << buffer_size;
+  }
+  // stopped before the end
+  ThreadedSource src(std::unique_ptr<ByteSource>(new FileSource(path)), 4096, 3);
+  char buf[100];
+  EXPECT_EQ(src.read(buf, sizeof(buf)), sizeof(buf));
+}
+
+TEST(AsyncReader, ReadsFilesConcurrently) {
+  std::string a = generated_file(), b = test::data_path("obs_v3.rnx");
+  std::string text_a = test::read_file(a), text_b = test::read_file(b);
+  AsyncReader io(4, 8192, 3);
+  EXPECT_EQ(io.open(test::data_path("no_such_file.rnx")), nullptr);
+  std::unique_ptr<ByteSource> sa = io.open(a), sb = io.open(b);
+  ASSERT_TRUE(sa && sb);
+  // interleaved reads of both files
+  std::string out_a, out_b;
+  char buf[5000];
+  bool more = true;
+  while (more) {
+    size_t na = sa->read(buf, sizeof(buf));
+    out_a.append(buf, na);
+    size_t nb = sb->read(buf, 123);
+    out_b.append(buf, nb);
+    more = na || nb;
+  }
+  EXPECT_EQ(out_a, text_a);
+  EXPECT_EQ(out_b, text_b);
+  std::string backend = io.backend();
+  EXPECT_TRUE(backend == "io_uring" || backend == "pread");
+}
+
+TEST(ByteSource, OpenTextSource) {
+  std::string path = test::data_path("obs_v3.rnx");
+  std::string text = test::read_file(path);
+  AsyncReader io;
+  for (int mode = 0; mode < 3; ++mode) {
+    std::unique_ptr<ByteSource> src = open_rinex_text_source(path, mode == 1, mode == 2 ? &io : nullptr);
+    ASSERT_TRUE(src) << mode;
+    EXPECT_EQ(read_all(*src), text) << mode;
+  }
+  EXPECT_EQ(open_rinex_text_source(test::data_path("no_such_file.rnx")), nullptr);
+}
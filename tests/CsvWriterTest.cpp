@@ -0,0 +1,71 @@
+// CsvWriterTest.cpp
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/CsvWriter.hpp"
+#include "RinexGenerator.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+std::string to_csv(const RinexObs& obs, const CsvOptions& opts = CsvOptions()) {
+  std::ostringstream out;
+  EXPECT_TRUE(write_obs_csv(out, obs, opts));
+  return out.str();
+}
+
+} // end namespace
+
+TEST(CsvWriter, FormatsRows) {
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), obs), ParseRinexError::Success);
+  std::string csv = to_csv(obs);
+  std::istringstream lines(csv);
+  std::string line;
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_EQ(line, "time,sat,C1C,L1C,D1C,S1C,C1X,L1X,C5X");
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_EQ(line, "2024-03-01 00:00:00.0000000,G05,23619095.450,124121776.314,-1234.567,45.250,,,");
+  size_t rows = 1;
+  while (std::getline(lines, line)) ++rows;
+  EXPECT_EQ(rows, obs.num_rows());
+
+  CsvOptions opts;
+  opts.obs_codes = {"L1C", "XXX"};
+  opts.sats = {SatId::parse("G30")};
+  opts.flags = true;
+  opts.delimiter = ';';
+  EXPECT_EQ(to_csv(obs, opts), "time;sat;L1C;L1C_lli;L1C_ssi\n"
+                               "2024-03-01 00:00:00.0000000;G30;-0.500;2;9\n");
+}
+
+TEST(CsvWriter, ThreadsAndStoragesGiveTheSameText) {
+  bench::GeneratorOptions g;
+  g.interval = 1.0;
+  g.duration = 600;
+  g.systems = "GRE";
+  std::string path = test::temp_path("generated.rnx");
+  bench::write_rinex(path, g);
+
+  RinexObs obs, fixed;
+  ParseOptions fixed_opts;
+  fixed_opts.fixed_point = true;
+  ASSERT_EQ(parse_rinex_obs(path, obs), ParseRinexError::Success);
+  ASSERT_EQ(parse_rinex_obs(path, fixed, fixed_opts), ParseRinexError::Success);
+
+  CsvOptions opts;
+  opts.flags = true;
+  std::string serial = to_csv(obs, opts);
+  opts.threads = 4;
+  opts.block_bytes = 4096;
+  EXPECT_EQ(to_csv(obs, opts), serial);
+  EXPECT_EQ(to_csv(fixed, opts), serial);
+
+  std::string csv_path = test::temp_path("obs.csv");
+  ASSERT_TRUE(write_obs_csv(csv_path, obs, opts));
+  EXPECT_EQ(test::read_file(csv_path), serial);
+}
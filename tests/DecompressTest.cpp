@@ -0,0 +1,113 @@
+// DecompressTest.cpp
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/ByteSource.hpp"
+#include "../include/Decompress.hpp"
+#include "../include/ObsFlags.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+std::string decode(const std::string& path) {
+  std::unique_ptr<ByteSource> src = open_rinex_text_source(path, false);
+  EXPECT_TRUE(src);
+  if (!src) return std::string();
+  std::string out, buf(4096, '\0');
+  while (size_t n = src->read(&buf[0], buf.size())) out.append(buf, 0, n);
+  EXPECT_FALSE(src->failed());
+  return out;
+}
+
+} // end namespace
+
+// G02 drops out of the second epoch and comes back in the third, where rnx2crx writes
+// its fields and LLI/SSI string afresh instead of as differences
+TEST(CrxSource, ReappearingSatelliteStartsOver) {
+  const char* crx =
+    "3.0                 COMPACT RINEX FORMAT                    CRINEX VERS   / TYPE\n"
+    "rnx2crx                                                     CRINEX PROG / DATE\n"
+    "     3.04           OBSERVATION DATA    G                   RINEX VERSION / TYPE\n"
+    "G    2 C1C L1C                                              SYS / # / OBS TYPES\n"
+    "                                                            END OF HEADER\n"
+    "> 2024 03 01 00 00  0.0000000  0  2      G01G02\n"
+    "\n"
+    "3&21000000000 3&110000000000  7 7\n"
+    "3&22000000000 3&115000000000  717\n"
+    "                   3              1         &&&\n"
+    "\n"
+    "30000 150000\n"
+    "                   6              2         G02\n"
+    "\n"
+    "0 0\n"
+    "3&22000060000 3&115000300000  6 6\n";
+  const char* rnx =
+    "     3.04           OBSERVATION DATA    G                   RINEX VERSION / TYPE\n"
+    "G    2 C1C L1C                                              SYS / # / OBS TYPES\n"
+    "                                                            END OF HEADER\n"
+    "> 2024 03 01 00 00  0.0000000  0  2\n"
+    "G01  21000000.000 7 110000000.000 7\n"
+    "G02  22000000.000 7 115000000.00017\n"
+    "> 2024 03 01 00 00 30.0000000  0  1\n"
+    "G01  21000030.000 7 110000150.000 7\n"
+    "> 2024 03 01 00 00 60.0000000  0  2\n"
+    "G01  21000060.000 7 110000300.000 7\n"
+    "G02  22000060.000 6 115000300.000 6\n";
+  std::string path = test::temp_path("reappear.crx");
+  test::write_file(path, crx);
+  EXPECT_EQ(decode(path), rnx);
+
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(path, obs), ParseRinexError::Success);
+  ASSERT_EQ(obs.num_rows(), 5u);
+  EXPECT_EQ(obs.flag(4, 1), pack_obs_flags(0, 6)); // not the LLI 1 of the first epoch
+}
+
+TEST(CompressSource, BlockModeResets) {
+  // at most 10-bit codes: the table fills and is cleared (code 256) several times
+  EXPECT_EQ(decode(test::data_path("arcs_v2.rnx.Z")), test::read_file(test::data_path("arcs_v2.rnx")));
+  EXPECT_EQ(decode(test::data_path("obs_v3.rnx.Z")), test::read_file(test::data_path("obs_v3.rnx")));
+
+  // a code past the table is an error, not a crash
+  std::string bytes = test::read_file(test::data_path("obs_v3.rnx.Z"));
+  bytes[4] = (char)0xff;
+  bytes[5] = (char)0xff;
+  std::string path = test::temp_path("corrupt.rnx.Z");
+  test::write_file(path, bytes);
+  RinexObs obs;
+  EXPECT_EQ(parse_rinex_obs(path, obs), ParseRinexError::DecompressionFailed);
+}
+
+#ifdef RINEX_HAVE_ZLIB
+TEST(GzipSource, Inflates) {
+  EXPECT_EQ(decode(test::data_path("obs_v3.rnx.gz")), test::read_file(test::data_path("obs_v3.rnx")));
+  // gzip wrapping Compact RINEX
+  EXPECT_EQ(decode(test::data_path("obs_v2.crx.gz")), test::read_file(test::data_path("obs_v2.rnx")));
+}
+#endif
+
+TEST(CrxSource, DecodesFixtures) {
+  // CRX 1.0 with continuation lines and an event record
+  EXPECT_EQ(decode(test::data_path("obs_v2.crx")), test::read_file(test::data_path("obs_v2.rnx")));
+  // CRX 3.0 with an event record; C07 has no types in the header, so no fields either
+  std::string v3 = test::read_file(test::data_path("obs_v3.rnx"));
+  size_t c07 = v3.find("C07");
+  v3.erase(c07 + 3, v3.find('\n', c07) - c07 - 3);
+  EXPECT_EQ(decode(test::data_path("obs_v3.crx")), v3);
+  // differences of up to third order along the arcs
+  EXPECT_EQ(decode(test::data_path("arcs_v2.crx")), test::read_file(test::data_path("arcs_v2.rnx")));
+  EXPECT_EQ(decode(test::data_path("arcs_v3.crx")), test::read_file(test::data_path("arcs_v3.rnx")));
+}
+
+TEST(CrxSource, ParsesLikePlainText) {
+  for (const char* name : {"obs_v2", "obs_v3", "arcs_v2", "arcs_v3"}) {
+    RinexObs plain, compact;
+    ASSERT_EQ(parse_rinex_obs(test::data_path(std::string(name) + ".rnx"), plain), ParseRinexError::Success);
+    ASSERT_EQ(parse_rinex_obs(test::data_path(std::string(name) + ".crx"), compact), ParseRinexError::Success);
+    test::expect_same_obs(compact, plain);
+  }
+}
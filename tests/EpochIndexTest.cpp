@@ -0,0 +1,74 @@
+// EpochIndexTest.cpp
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/EpochIndex.hpp"
+#include "RinexGenerator.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+TEST(EpochIndex, IndexesEveryEpoch) {
+  std::string path = test::data_path("obs_v3.rnx");
+  std::string text = test::read_file(path);
+  EpochIndex index;
+  ASSERT_EQ(index.build(path), ParseRinexError::Success);
+  // event records are not indexed
+  ASSERT_EQ(index.size(), 2u);
+  EXPECT_EQ(index[0].time, gps_time_ns(2024, 3, 1, 0, 0, 0.0));
+  EXPECT_EQ(index[1].time, gps_time_ns(2024, 3, 1, 0, 0, 30.0));
+  EXPECT_EQ(text.compare(index[1].offset, 23, "> 2024 03 01 00 00 30.0"), 0);
+  EXPECT_EQ(index.source_size(), text.size());
+
+  std::string idx = test::temp_path("obs.idx");
+  ASSERT_TRUE(index.save(idx));
+  EpochIndex loaded;
+  ASSERT_EQ(loaded.load(idx), ParseRinexError::Success);
+  ASSERT_EQ(loaded.size(), index.size());
+  EXPECT_EQ(loaded[1].offset, index[1].offset);
+  EXPECT_EQ(loaded.source_mtime(), index.source_mtime());
+
+  test::write_file(idx, "not an index");
+  EXPECT_EQ(loaded.load(idx), ParseRinexError::InvalidCache);
+  // open rebuilds the damaged sidecar
+  ASSERT_EQ(loaded.open(path, idx), ParseRinexError::Success);
+  EXPECT_EQ(loaded.size(), 2u);
+  ASSERT_EQ(loaded.load(idx), ParseRinexError::Success);
+}
+
+TEST(EpochIndex, ReadsTimeRanges) {
+  bench::GeneratorOptions g;
+  g.version = 3;
+  g.interval = 30.0;
+  g.duration = 3600;
+  g.num_sats = 10;
+  std::string path = test::temp_path("generated.rnx");
+  bench::write_rinex(path, g);
+
+  RinexObs all;
+  ASSERT_EQ(parse_rinex_obs(path, all), ParseRinexError::Success);
+  EpochIndex index;
+  ASSERT_EQ(index.build(path), ParseRinexError::Success);
+  ASSERT_EQ(index.size(), all.num_epochs());
+
+  int64_t t0 = all.epoch_time[10], t1 = all.epoch_time[25];
+  EXPECT_EQ(index.range(t0, t1), std::make_pair((size_t)10, (size_t)25));
+  EXPECT_EQ(index.range(t0 + 1, t1 + 1), std::make_pair((size_t)11, (size_t)26));
+  EXPECT_EQ(index.range(t1, t0).first, index.range(t1, t0).second);
+
+  RinexObs part;
+  ASSERT_EQ(read_rinex_range(path, index, t0, t1, part), ParseRinexError::Success);
+  ASSERT_EQ(part.num_epochs(), 15u);
+  for (size_t e = 0; e < part.num_epochs(); ++e) {
+    EXPECT_EQ(part.epoch_time[e], all.epoch_time[10 + e]);
+    for (size_t r = part.rows_begin(e), q = all.rows_begin(10 + e); r < part.rows_end(e); ++r, ++q) {
+      EXPECT_EQ(part.value(r, 0), all.value(q, 0));
+    }
+  }
+
+  // an index of another file does not match
+  EpochIndex other;
+  ASSERT_EQ(other.build(test::data_path("obs_v3.rnx")), ParseRinexError::Success);
+  EXPECT_EQ(read_rinex_range(path, other, t0, t1, part), ParseRinexError::InvalidCache);
+}
@@ -0,0 +1,97 @@
+// EpochReaderTest.cpp
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/EpochReader.hpp"
+#include "../include/FieldDecoder.hpp"
+#include "../include/ParseStats.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+// every epoch of path, through EpochReader
+RinexObs read_epochs(const std::string& path, bool io_thread = false) {
+  EpochReader reader;
+  RinexObs obs;
+  EXPECT_EQ(reader.open(path, io_thread), ParseRinexError::Success);
+  static_cast<RinexHeader&>(obs) = reader.header();
+  obs.reset_columns();
+  ObsEpoch ep;
+  while (reader.next(ep)) obs.append(ep);
+  return obs;
+}
+
+} // end namespace
+
+TEST(EpochReader, MatchesParse) {
+  for (const char* name : {"obs_v2.rnx", "obs_v3.rnx"}) {
+    RinexObs parsed;
+    ASSERT_EQ(parse_rinex_obs(test::data_path(name), parsed), ParseRinexError::Success);
+    test::expect_same_obs(read_epochs(test::data_path(name)), parsed);
+    test::expect_same_obs(read_epochs(test::data_path(name), true), parsed);
+  }
+}
+
+TEST(EpochReader, SelectedObsCodes) {
+  EpochReader reader;
+  ASSERT_EQ(reader.open(test::data_path("obs_v3.rnx")), ParseRinexError::Success);
+  ASSERT_EQ(reader.select_obs_types({"S1C"}), ParseRinexError::Success);
+  ObsEpoch ep;
+  ASSERT_TRUE(reader.next(ep));
+  EXPECT_EQ(ep.num_obs, 1u);
+  EXPECT_EQ(ep.value(0, 0), 45.25);
+}
+
+TEST(EpochReader, ForEachEpochStopsEarly) {
+  RinexHeader hdr;
+  std::vector<int64_t> times;
+  ASSERT_EQ(for_each_epoch(test::data_path("obs_v2.rnx"), hdr,
+                           [&](const ObsEpoch& ep) {
+                             times.push_back(ep.time);
+                             return false;
+                           }),
+            ParseRinexError::Success);
+  EXPECT_EQ(hdr.obs_types.size(), 7u);
+  EXPECT_EQ(times, (std::vector<int64_t>{gps_time_ns(2024, 3, 1, 0, 0, 0.0)}));
+}
+
+TEST(EpochReader, TruncatedEpochIsDropped) {
+  std::string text = test::read_file(test::data_path("obs_v3.rnx"));
+  std::string path = test::temp_path("truncated.rnx");
+  // cut the file after the first satellite record of the last epoch
+  size_t last = text.rfind("\n>") + 1;
+  test::write_file(path, text.substr(0, text.find('\n', last + 1) + 1));
+  ParseStats stats;
+  EpochReader reader;
+  reader.set_stats(&stats);
+  ASSERT_EQ(reader.open(path), ParseRinexError::Success);
+  ObsEpoch ep;
+  size_t n = 0;
+  while (reader.next(ep)) ++n;
+  EXPECT_EQ(n, 1u);
+  EXPECT_EQ(stats.epochs, 1u);
+  EXPECT_EQ(stats.dropped_epochs, 1u);
+}
+
+TEST(EpochReader, FindEpochStart) {
+  for (const char* name : {"obs_v2.rnx", "obs_v3.rnx"}) {
+    std::string text = test::read_file(test::data_path(name));
+    size_t eoh = text.find("END OF HEADER");
+    std::string_view body = std::string_view(text).substr(text.find('\n', eoh) + 1);
+    bool is_v3 = name[5] == '3';
+    size_t first = find_epoch_start(body, 0, is_v3);
+    EXPECT_EQ(first, 0u) << name;
+    // the next start after the first byte is the event record, whose lines are skipped
+    size_t second = find_epoch_start(body, 1, is_v3);
+    ASSERT_LT(second, body.size()) << name;
+    ObsEpoch ep;
+    std::string_view line = body.substr(second, body.find('\n', second) - second);
+    ASSERT_TRUE(is_v3 ? decode_epoch_v3(line, ep) : decode_epoch_v2(line, ep)) << name;
+    EXPECT_EQ(ep.event_flag, 4) << name;
+    EXPECT_EQ(find_epoch_start(body, body.size() - 1, is_v3), body.size()) << name;
+  }
+}
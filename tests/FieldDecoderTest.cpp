@@ -0,0 +1,86 @@
+// FieldDecoderTest.cpp
+#include <cstdlib>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/FieldDecoder.hpp"
+
+using namespace rinex;
+
+TEST(FieldDecoder, IntegerFields) {
+  int v = 0;
+  EXPECT_TRUE(decode_int_field("  12", 0, 4, v));
+  EXPECT_EQ(v, 12);
+  EXPECT_TRUE(decode_int_field("xx -3 ", 2, 4, v));
+  EXPECT_EQ(v, -3);
+  EXPECT_FALSE(decode_int_field("    ", 0, 4, v)); // blank
+  EXPECT_FALSE(decode_int_field(" 1a ", 0, 4, v));
+  EXPECT_FALSE(decode_int_field("12", 5, 4, v));    // past the end of the line
+}
+
+TEST(FieldDecoder, FixedFieldsMatchStrtod) {
+  for (const char* f : {"  23619095.450", "        -0.500", " 124121776.314", "          45.2",
+                        "            1.", "   .125", "-9999999999.999"}) {
+    double v = 0;
+    ASSERT_TRUE(decode_fixed_field(f, 0, 15, v)) << f;
+    EXPECT_EQ(v, std::strtod(f, nullptr)) << f;
+  }
+  double v = 0;
+  EXPECT_FALSE(decode_fixed_field("              ", 0, 14, v));
+  EXPECT_FALSE(decode_fixed_field("     1.2.3    ", 0, 14, v));
+  EXPECT_FALSE(decode_fixed_field("     12x.5    ", 0, 14, v));
+}
+
+TEST(FieldDecoder, SecondsAsNanoseconds) {
+  int64_t ns = 0;
+  EXPECT_TRUE(decode_seconds_ns(" 30.0000000", 0, 11, ns));
+  EXPECT_EQ(ns, 30 * kNsPerSecond);
+  EXPECT_TRUE(decode_seconds_ns(" 59.9999999", 0, 11, ns));
+  EXPECT_EQ(ns, 59 * kNsPerSecond + 999999900);
+  EXPECT_TRUE(decode_seconds_ns("  0.123456789", 0, 13, ns));
+  EXPECT_EQ(ns, 123456789);
+  EXPECT_FALSE(decode_seconds_ns(" -1.0000000", 0, 11, ns));
+  // whole seconds of a malformed line that would overflow int64 nanoseconds
+  EXPECT_TRUE(decode_seconds_ns("999.0000000", 0, 11, ns));
+  EXPECT_FALSE(decode_seconds_ns("9999.000000", 0, 11, ns));
+  EXPECT_FALSE(decode_seconds_ns("99999999999999", 0, 14, ns));
+}
+
+TEST(FieldDecoder, ObservationSlot) {
+  std::string line = "G05  23619095.450 7 124121776.31415";
+  double v = 0;
+  ASSERT_TRUE(decode_obs_value(line, kV3FirstObsCol, v));
+  EXPECT_EQ(v, 23619095.450);
+  EXPECT_EQ(decode_obs_flags(line, kV3FirstObsCol), pack_obs_flags(0, 7));
+  EXPECT_EQ(decode_obs_flags(line, kV3FirstObsCol + kObsSlotWidth), pack_obs_flags(1, 5));
+  // columns past the end of the line are blank
+  EXPECT_FALSE(decode_obs_value(line, kV3FirstObsCol + 2 * kObsSlotWidth, v));
+  EXPECT_EQ(decode_obs_flags(line, kV3FirstObsCol + 2 * kObsSlotWidth), 0);
+}
+
+TEST(FieldDecoder, EpochRecordV3) {
+  ObsEpoch ep;
+  ASSERT_TRUE(decode_epoch_v3("> 2024 03 01 12 34 56.5000000  0 31", ep));
+  EXPECT_EQ(ep.time, gps_time_from_day(2024, 3, 1, (12 * 3600 + 34 * 60 + 56) * kNsPerSecond + 500000000));
+  EXPECT_EQ(ep.event_flag, 0);
+  EXPECT_EQ(ep.num_sv, 31);
+  ASSERT_TRUE(decode_epoch_v3("> 2024 03 01 00 00 15.0000000  4  2", ep));
+  EXPECT_EQ(ep.event_flag, 4);
+  EXPECT_FALSE(decode_epoch_v3("G05  23619095.450 7 124121776.31415     -1234.567", ep));
+  EXPECT_FALSE(decode_epoch_v3("> 2024 03 01", ep));
+}
+
+TEST(FieldDecoder, EpochRecordV2) {
+  ObsEpoch ep;
+  ASSERT_TRUE(decode_epoch_v2(" 24  3  1  0  0 30.0000000  0 13G01G02G03", ep));
+  EXPECT_EQ(ep.time, gps_time_from_day(2024, 3, 1, 30 * kNsPerSecond));
+  EXPECT_EQ(ep.num_sv, 13);
+  // two digit years: 80-99 are 19xx, 00-79 are 20xx
+  ASSERT_TRUE(decode_epoch_v2(" 80  1  6  0  0  0.0000000  0  1G01", ep));
+  EXPECT_EQ(ep.time, 0);
+  ASSERT_TRUE(decode_epoch_v2(" 79  1  1  0  0  0.0000000     1G01", ep));
+  EXPECT_EQ(ep.time, gps_time_from_day(2079, 1, 1, 0));
+  EXPECT_EQ(ep.event_flag, 0); // blank flag
+  EXPECT_FALSE(decode_epoch_v2("  20000000.000 1  20000007.919 2  20000015.838 3", ep));
+}
@@ -0,0 +1,46 @@
+// GnssTimeTest.cpp
+#include <gtest/gtest.h>
+
+#include "../include/GnssTime.hpp"
+
+using namespace rinex;
+
+TEST(GnssTime, GpsEpochIsZero) {
+  EXPECT_EQ(gps_time_ns(1980, 1, 6, 0, 0, 0.0), 0);
+  EXPECT_EQ(gps_week(0), 0);
+  EXPECT_EQ(gps_time_ns(1980, 1, 5, 23, 59, 59.0), -kNsPerSecond);
+  EXPECT_EQ(gps_week(-1), -1);
+}
+
+TEST(GnssTime, WeekAndSecondsOfWeek) {
+  // 2024-03-01 is a Friday of GPS week 2303
+  int64_t t = gps_time_ns(2024, 3, 1, 12, 0, 0.0);
+  EXPECT_EQ(gps_week(t), 2303);
+  EXPECT_DOUBLE_EQ(gps_seconds_of_week(t), 5 * 86400.0 + 12 * 3600.0);
+}
+
+TEST(GnssTime, CalendarRoundTrip) {
+  for (int64_t day = -400; day < 40000; day += 37) {
+    int64_t t = day * kNsPerDay + 45296 * kNsPerSecond + 500000000; // 12:34:56.5
+    CalendarTime c = calendar_from_gps_ns(t);
+    EXPECT_EQ(c.hour, 12);
+    EXPECT_EQ(c.minute, 34);
+    EXPECT_DOUBLE_EQ(c.second, 56.5);
+    EXPECT_EQ(gps_time_ns(c.year, c.month, c.day, c.hour, c.minute, c.second), t);
+  }
+}
+
+TEST(GnssTime, CivilDays) {
+  int y, m, d;
+  for (int64_t z = -800000; z < 800000; z += 97) {
+    civil_from_days(z, y, m, d);
+    ASSERT_EQ(days_from_civil(y, m, d), z);
+    ASSERT_GE(m, 1);
+    ASSERT_LE(m, 12);
+    ASSERT_GE(d, 1);
+    ASSERT_LE(d, 31);
+  }
+  civil_from_days(days_from_civil(2024, 2, 28) + 1, y, m, d);
+  EXPECT_EQ(m, 2);
+  EXPECT_EQ(d, 29);
+}
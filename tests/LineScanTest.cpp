@@ -0,0 +1,116 @@
+// LineScanTest.cpp
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/ByteSource.hpp"
+#include "../include/LineScan.hpp"
+#include "../include/MappedFile.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+// hands out text a few bytes at a time, to cut lines at every possible place
+class TrickleSource : public ByteSource {
+public:
+  TrickleSource(std::string text, size_t step) : text_(std::move(text)), step_(step) {}
+  size_t read(char* buf, size_t n) override {
+    size_t k = std::min({n, step_, text_.size() - pos_});
+    memcpy(buf, text_.data() + pos_, k);
+    pos_ += k;
+    return k;
+  }
+
+private:
+  std::string text_;
+  size_t step_;
+  size_t pos_ = 0;
+};
+
+std::vector<std::string> all_lines(LineScanner& scanner) {
+  std::vector<std::string> lines;
+  std::string_view line;
+  while (scanner.next(line)) lines.emplace_back(line);
+  return lines;
+}
+
+} // end namespace
+
+TEST(LineScanner, SplitsLinesInPlace) {
+  std::string text = "first\r\nsecond\n\nlast without newline";
+  LineScanner scanner(text);
+  std::string_view line;
+  ASSERT_TRUE(scanner.next(line));
+  EXPECT_EQ(line, "first");
+  EXPECT_EQ(line.data(), text.data()); // a view into the buffer, not a copy
+  EXPECT_EQ(scanner.offset(), 7u);
+  ASSERT_TRUE(scanner.next(line));
+  EXPECT_EQ(line, "second");
+  ASSERT_TRUE(scanner.next(line));
+  EXPECT_EQ(line, "");
+  ASSERT_TRUE(scanner.next(line));
+  EXPECT_EQ(line, "last without newline");
+  EXPECT_FALSE(scanner.next(line));
+
+  scanner.seek(7);
+  ASSERT_TRUE(scanner.next(line));
+  EXPECT_EQ(line, "second");
+}
+
+TEST(LineScanner, StreamModeMatchesBufferMode) {
+  std::string text = test::read_file(test::data_path("obs_v3.rnx"));
+  LineScanner whole(text);
+  std::vector<std::string> expected = all_lines(whole);
+  for (size_t step : {1, 3, 80, 4096}) {
+    TrickleSource src(text, step);
+    LineScanner scanner(&src);
+    EXPECT_EQ(all_lines(scanner), expected) << "step " << step;
+  }
+}
+
+TEST(FindNewline, MatchesMemchr) {
+  std::mt19937 rng(7);
+  std::vector<char> buf(300);
+  for (int round = 0; round < 2000; ++round) {
+    for (char& c : buf) c = (rng() % 40 == 0) ? '\n' : (char)('A' + rng() % 26);
+    size_t begin = rng() % 64, end = begin + rng() % (buf.size() - begin);
+    const char* p = buf.data() + begin;
+    const char* e = buf.data() + end;
+    const char* want = static_cast<const char*>(memchr(p, '\n', (size_t)(e - p)));
+    EXPECT_EQ(find_newline(p, e), want ? want : e) << line_scan_kernel();
+  }
+}
+
+TEST(HeaderLabel, ClassifiesRecords) {
+  auto record = [](const std::string& data, const std::string& label) {
+    std::string line = data;
+    line.resize(kHeaderLabelCol, ' ');
+    return line + label;
+  };
+  EXPECT_EQ(header_label(record("     3.04           OBSERVATION DATA    M", "RINEX VERSION / TYPE")),
+            HeaderLabel::VersionType);
+  EXPECT_EQ(header_label(record("G    4 C1C L1C D1C S1C", "SYS / # / OBS TYPES")), HeaderLabel::SysObsTypes);
+  EXPECT_EQ(header_label(record("     7    C1    L1", "# / TYPES OF OBSERV")), HeaderLabel::TypesOfObserv);
+  EXPECT_EQ(header_label(record("", "END OF HEADER")), HeaderLabel::EndOfHeader);
+  EXPECT_EQ(header_label(record("anything", "COMMENT")), HeaderLabel::Comment);
+  EXPECT_EQ(header_label(record("", "NOT A LABEL")), HeaderLabel::Unknown);
+  // a label out of its columns is still found for the records the parser needs
+  EXPECT_EQ(header_label("   END OF HEADER"), HeaderLabel::EndOfHeader);
+}
+
+TEST(MappedFile, ViewsWholeFile) {
+  std::string path = test::data_path("obs_v2.rnx");
+  MappedFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(file.view(), test::read_file(path));
+
+  MappedFile missing;
+  EXPECT_FALSE(missing.open(test::data_path("no_such_file.rnx")));
+  EXPECT_FALSE(missing.is_open());
+}
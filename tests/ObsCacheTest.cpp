@@ -0,0 +1,153 @@
+// ObsCacheTest.cpp
+#include <sys/stat.h>
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/ObsCache.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+TEST(ObsCache, RoundTrip) {
+  for (bool fixed_point : {false, true}) {
+    ParseOptions opts;
+    opts.fixed_point = fixed_point;
+    RinexObs obs;
+    ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), obs, opts), ParseRinexError::Success);
+    std::string path = test::temp_path("obs.cache");
+    ASSERT_TRUE(write_obs_cache(path, obs));
+
+    ObsCache cache;
+    ASSERT_EQ(cache.open(path), ParseRinexError::Success);
+    EXPECT_EQ(cache.header().fixed_point, fixed_point);
+    EXPECT_EQ(cache.header().sys_obs_types[(size_t)GnssSystem::Galileo], obs.sys_obs_types[(size_t)GnssSystem::Galileo]);
+    ASSERT_EQ(cache.num_rows(), obs.num_rows());
+    EXPECT_EQ(cache.sat(cache.row_sat()[1]), SatId::parse("R12"));
+    if (fixed_point) {
+      EXPECT_EQ(cache.fixed_column(0)[0], 23619095450);
+      EXPECT_EQ(cache.column(0), nullptr);
+    } else {
+      EXPECT_EQ(cache.column(0)[0], 23619095.450);
+      EXPECT_EQ(cache.fixed_column(0), nullptr);
+    }
+    EXPECT_EQ(cache.flags(1)[0], obs.flag(0, 1));
+
+    RinexObs back;
+    ASSERT_EQ(read_obs_cache(path, back), ParseRinexError::Success);
+    EXPECT_EQ(back.fixed_point, fixed_point);
+    test::expect_same_obs(back, obs);
+  }
+}
+
+TEST(ObsCache, RejectsOtherFiles) {
+  ObsCache cache;
+  EXPECT_EQ(cache.open(test::data_path("obs_v3.rnx")), ParseRinexError::InvalidCache);
+  EXPECT_EQ(cache.open(test::data_path("no_such_file.cache")), ParseRinexError::FileNotFound);
+
+  // a cache cut short
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v2.rnx"), obs), ParseRinexError::Success);
+  std::string path = test::temp_path("obs.cache");
+  ASSERT_TRUE(write_obs_cache(path, obs));
+  std::string bytes = test::read_file(path);
+  test::write_file(path, bytes.substr(0, bytes.size() - 8));
+  EXPECT_EQ(cache.open(path), ParseRinexError::InvalidCache);
+}
+
+TEST(ObsCache, RejectsInconsistentTables) {
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), obs), ParseRinexError::Success);
+  std::string path = test::temp_path("obs.cache");
+  ASSERT_TRUE(write_obs_cache(path, obs));
+  const std::string good = test::read_file(path);
+
+  // file offsets of the tables, from where the mapping puts them
+  size_t row_sat = 0, epoch_begin = 0;
+  {
+    ObsCache cache;
+    ASSERT_EQ(cache.open(path), ParseRinexError::Success);
+    int64_t t0 = obs.epoch_time[0];
+    size_t epoch_time = good.find(std::string(reinterpret_cast<const char*>(&t0), sizeof(t0)));
+    ASSERT_NE(epoch_time, std::string::npos);
+    const char* base = reinterpret_cast<const char*>(cache.epoch_time()) - epoch_time;
+    row_sat = (size_t)(reinterpret_cast<const char*>(cache.row_sat()) - base);
+    epoch_begin = (size_t)(reinterpret_cast<const char*>(cache.epoch_begin()) - base);
+  }
+  auto expect_invalid = [&](size_t offset, const void* value, size_t n, const char* what) {
+    std::string bad = good;
+    memcpy(&bad[offset], value, n);
+    test::write_file(path, bad);
+    ObsCache cache;
+    EXPECT_EQ(cache.open(path), ParseRinexError::InvalidCache) << what;
+  };
+
+  uint16_t sat = (uint16_t)obs.sats.size();
+  expect_invalid(row_sat + 2 * sizeof(uint16_t), &sat, sizeof(sat), "row satellite past the table");
+  uint32_t begin = 1;
+  expect_invalid(epoch_begin, &begin, sizeof(begin), "first epoch not at row 0");
+  begin = (uint32_t)obs.num_rows() + 1;
+  expect_invalid(epoch_begin + sizeof(uint32_t), &begin, sizeof(begin), "epoch past the rows");
+  // num_rows in the header, so large that the section sizes overflow
+  uint64_t rows = 1ull << 61;
+  expect_invalid(32, &rows, sizeof(rows), "overflowing section sizes");
+
+  // parse_rinex_obs_cached parses the file again
+  std::string bad = good;
+  uint32_t later = 2;
+  memcpy(&bad[epoch_begin], &later, sizeof(later));
+  test::write_file(path, bad);
+  RinexObs again;
+  ASSERT_EQ(parse_rinex_obs_cached(test::data_path("obs_v3.rnx"), path, again), ParseRinexError::Success);
+  test::expect_same_obs(again, obs);
+  ObsCache cache;
+  EXPECT_EQ(cache.open(path), ParseRinexError::Success); // and rewrote the cache
+}
+
+TEST(ObsCache, ParseCachedFollowsSource) {
+  std::string src = test::temp_path("obs.rnx");
+  std::string path = test::temp_path("obs.cache");
+  std::string text = test::read_file(test::data_path("obs_v3.rnx"));
+  test::write_file(src, text);
+
+  RinexObs first, second;
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, first), ParseRinexError::Success);
+  ObsCache cache;
+  ASSERT_EQ(cache.open(path), ParseRinexError::Success);
+  EXPECT_EQ(cache.source_size(), text.size());
+  cache.close();
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, second), ParseRinexError::Success);
+  test::expect_same_obs(first, second);
+
+  // a selection or storage the cache was not made with is parsed again
+  ParseOptions opts;
+  opts.obs_codes = {"C1C"};
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, second, opts), ParseRinexError::Success);
+  EXPECT_EQ(second.obs_types, (std::vector<std::string>{"C1C"}));
+  opts.obs_codes.clear();
+  opts.fixed_point = true;
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, second, opts), ParseRinexError::Success);
+  EXPECT_TRUE(second.fixed_point);
+  test::expect_same_obs(first, second);
+
+  // a request that selects the cached codes hits the cache, whatever its spelling
+  opts.fixed_point = false;
+  opts.obs_codes = {"L1C", "C5X", "C1C"};
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, second, opts), ParseRinexError::Success);
+  struct stat before;
+  ASSERT_EQ(stat(path.c_str(), &before), 0);
+  opts.obs_codes = {"L1C", "D9Z", "C5X", "L1C", "C1C"};
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, second, opts), ParseRinexError::Success);
+  EXPECT_EQ(second.obs_types, (std::vector<std::string>{"L1C", "C5X", "C1C"}));
+  struct stat after;
+  ASSERT_EQ(stat(path.c_str(), &after), 0);
+  EXPECT_EQ(after.st_ino, before.st_ino); // not written again
+  opts.obs_codes.clear();
+
+  // so is a source that changed: drop the last epoch
+  test::write_file(src, text.substr(0, text.rfind("\n>") + 1));
+  ASSERT_EQ(parse_rinex_obs_cached(src, path, second), ParseRinexError::Success);
+  EXPECT_EQ(second.num_epochs(), 1u);
+}
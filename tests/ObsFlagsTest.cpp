@@ -0,0 +1,38 @@
+// ObsFlagsTest.cpp
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/ObsFlags.hpp"
+
+using namespace rinex;
+
+TEST(ObsFlags, PacksDigits) {
+  uint8_t f = pack_obs_flags(5, 9);
+  EXPECT_EQ(obs_lli(f), 5);
+  EXPECT_EQ(obs_ssi(f), 9);
+  EXPECT_EQ(pack_obs_flags(0, 0), 0);
+}
+
+TEST(ObsFlags, ScansMatchLoop) {
+  std::mt19937 rng(11);
+  for (size_t n : {0, 1, 31, 63, 64, 65, 200, 1000}) {
+    std::vector<uint8_t> flags(n);
+    for (uint8_t& f : flags) f = (rng() % 23 == 0) ? pack_obs_flags(rng() % 8, rng() % 10) : pack_obs_flags(0, rng() % 10);
+    for (uint8_t mask : {kLliLossOfLock, kLliHalfCycle, kLliSlipMask, kLliAntiSpoofing}) {
+      std::vector<uint32_t> want;
+      for (size_t i = 0; i < n; ++i) {
+        if (flags[i] & mask) want.push_back((uint32_t)i);
+      }
+      EXPECT_EQ(flagged_rows(flags.data(), n, mask), want) << n;
+      EXPECT_EQ(count_flagged(flags.data(), n, mask), want.size()) << n;
+      size_t from = n ? rng() % n : 0;
+      size_t first = n;
+      for (uint32_t i : want) {
+        if (i >= from) { first = i; break; }
+      }
+      EXPECT_EQ(find_flagged(flags.data(), n, mask, from), first) << n;
+    }
+  }
+}
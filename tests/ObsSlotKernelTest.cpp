@@ -0,0 +1,117 @@
+// ObsSlotKernelTest.cpp
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/FieldDecoder.hpp"
+#if !defined(RINEX_NO_SIMD) && defined(__x86_64__)
+#include "../include/LineScan.hpp"
+#endif
+
+using namespace rinex;
+
+namespace {
+
+// a random 14 column value field, mostly the way RINEX writers print them
+std::string random_field(std::mt19937& rng) {
+  char buf[64];
+  double mag = std::pow(10.0, (double)(rng() % 11)) * (rng() % 1000000) / 1e6;
+  bool neg = rng() % 3 == 0;
+  switch (rng() % 8) {
+  case 0:
+    return std::string(kObsValueWidth, ' ');
+  case 1:
+  case 2: // F14.3
+    snprintf(buf, sizeof(buf), "%14.3f", neg ? -mag : mag);
+    break;
+  case 3: // other decimals
+    snprintf(buf, sizeof(buf), "%14.*f", (int)(rng() % 6), neg ? -mag : mag);
+    break;
+  case 4: // left aligned
+    snprintf(buf, sizeof(buf), "%-14.3f", neg ? -mag : mag);
+    break;
+  case 5: // the extremes of F14.3
+    snprintf(buf, sizeof(buf), "%s", neg ? "-999999999.999" : "9999999999.999");
+    break;
+  default: { // anything
+    const char chars[] = " 0123456789.-+eEx";
+    std::string f(kObsValueWidth, ' ');
+    for (char& c : f) c = chars[rng() % (sizeof(chars) - 1)];
+    return f;
+  }
+  }
+  std::string f = buf;
+  if (f.size() > kObsValueWidth) f = f.substr(f.size() - kObsValueWidth); // out of range
+  return f;
+}
+
+char random_flag(std::mt19937& rng) {
+  const char chars[] = "  0123456789x";
+  return chars[rng() % (sizeof(chars) - 1)];
+}
+
+// decode_obs_slots against decode_obs_value / decode_obs_flags on random records
+template <typename T>
+void compare_with_reference(uint32_t seed) {
+  std::mt19937 rng(seed);
+  const T kUntouched = (T)-777;
+  for (int round = 0; round < 20000; ++round) {
+    size_t nslots = 1 + rng() % 12;
+    std::string line = "G05";
+    for (size_t s = 0; s < nslots; ++s) {
+      line += random_field(rng);
+      line += random_flag(rng);
+      line += random_flag(rng);
+    }
+    // records end anywhere: trimmed, or cut in a field
+    if (rng() % 2) line.erase(line.find_last_not_of(' ') + 1);
+    if (rng() % 4 == 0) line.resize(rng() % (line.size() + 1));
+
+    // a random subset of the slots, as the type selection makes them
+    size_t slot_base = rng() % 3;
+    std::vector<ObsSlot> slots;
+    for (size_t s = 0; s < nslots + 1; ++s) {
+      if (rng() % 4 != 0) slots.push_back({(uint16_t)(slot_base + s), (uint16_t)slots.size()});
+    }
+    std::vector<T> values(slots.size(), kUntouched);
+    std::vector<uint8_t> flags(slots.size(), 0xee);
+    decode_obs_slots(line, kV3FirstObsCol, slot_base, slots.data(), slots.size(), values.data(), flags.data());
+
+    for (size_t i = 0; i < slots.size(); ++i) {
+      size_t col = kV3FirstObsCol + (slots[i].slot - slot_base) * kObsSlotWidth;
+      double v = 0;
+      T want = kUntouched;
+      if (decode_obs_value(line, col, v)) {
+        if constexpr (std::is_same<T, double>::value) want = v;
+        else want = to_fixed_point(v);
+      }
+      ASSERT_EQ(values[i], want) << "slot " << i << " of \"" << line << "\" (" << obs_decode_kernel() << ")";
+      ASSERT_EQ(flags[i], decode_obs_flags(line, col)) << "slot " << i << " of \"" << line << "\"";
+    }
+  }
+}
+
+} // end namespace
+
+TEST(ObsSlotKernel, RunsTheExpectedKernel) {
+  // the second run of this suite sets RINEX_NO_AVX2, and a separate binary is built
+  // with RINEX_NO_SIMD
+#if defined(RINEX_NO_SIMD) || !defined(__x86_64__)
+  EXPECT_STREQ(obs_decode_kernel(), "scalar");
+#else
+  EXPECT_STREQ(obs_decode_kernel(), simd_use_avx2() ? "avx2" : "sse2");
+  if (std::getenv("RINEX_NO_AVX2")) {
+    EXPECT_STREQ(obs_decode_kernel(), "sse2");
+  }
+#endif
+}
+
+TEST(ObsSlotKernel, DoubleMatchesReference) { compare_with_reference<double>(21); }
+
+TEST(ObsSlotKernel, FixedPointMatchesReference) { compare_with_reference<int64_t>(22); }
@@ -0,0 +1,251 @@
+// ParseRinexTest.cpp
+#include <sys/stat.h>
+
+#include <cmath>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/ObsFlags.hpp"
+#include "../include/ParseRinex.hpp"
+#include "RinexGenerator.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+// row of sv in epoch e, or -1
+int row_of(const RinexObs& obs, size_t e, const char* sv) {
+  for (size_t r = obs.rows_begin(e); r < obs.rows_end(e); ++r) {
+    if (obs.sats[obs.row_sat[r]] == SatId::parse(sv)) return (int)r;
+  }
+  return -1;
+}
+
+// value of the RINEX 2 fixture: satellite i, type t of the epoch at 15 s * e
+double v2_value(int e, int i, int t) {
+  return (double)(20000000000 + 1000003LL * i + 7919 * t + 13 * e) / 1000.0;
+}
+
+std::string generated_file(int version, double duration) {
+  bench::GeneratorOptions g;
+  g.version = version;
+  g.interval = 1.0;
+  g.duration = duration;
+  g.num_sats = 14;
+  g.systems = "GRE";
+  std::string path = test::temp_path("generated.rnx");
+  bench::write_rinex(path, g);
+  return path;
+}
+
+} // end namespace
+
+TEST(ParseRinex, MultiGnssV3) {
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), obs), ParseRinexError::Success);
+  EXPECT_TRUE(obs.is_v3);
+  EXPECT_EQ(obs.obs_types, (std::vector<std::string>{"C1C", "L1C", "D1C", "S1C", "C1X", "L1X", "C5X"}));
+  EXPECT_EQ(obs.sys_obs_types[(size_t)GnssSystem::GLONASS], (std::vector<std::string>{"C1C", "L1C"}));
+
+  // the event record is skipped, and so is C07: BeiDou has no types in the header
+  ASSERT_EQ(obs.num_epochs(), 2u);
+  EXPECT_EQ(obs.epoch_time[0], gps_time_ns(2024, 3, 1, 0, 0, 0.0));
+  EXPECT_EQ(obs.epoch_time[1], gps_time_ns(2024, 3, 1, 0, 0, 30.0));
+  EXPECT_EQ(obs.rows_end(0) - obs.rows_begin(0), 4u);
+  EXPECT_EQ(obs.rows_end(1) - obs.rows_begin(1), 2u);
+  EXPECT_EQ(row_of(obs, 1, "C07"), -1);
+
+  int g05 = row_of(obs, 0, "G05");
+  ASSERT_GE(g05, 0);
+  EXPECT_EQ(obs.value(g05, 0), 23619095.450);
+  EXPECT_EQ(obs.value(g05, 1), 124121776.314);
+  EXPECT_EQ(obs.value(g05, 2), -1234.567);
+  EXPECT_EQ(obs.value(g05, 3), 45.250);
+  EXPECT_EQ(obs.value(g05, 4), 0.0); // not a GPS type
+  EXPECT_EQ(obs.flag(g05, 0), pack_obs_flags(0, 7));
+  EXPECT_EQ(obs.flag(g05, 1), pack_obs_flags(1, 5));
+
+  int r12 = row_of(obs, 0, "R12");
+  EXPECT_EQ(obs.value(r12, 0), 19985432.100);
+  EXPECT_EQ(obs.value(r12, 1), 106876543.210);
+  EXPECT_EQ(obs.flag(r12, 1), pack_obs_flags(1, 4));
+
+  int e11 = row_of(obs, 0, "E11");
+  EXPECT_EQ(obs.value(e11, 0), 0.0);
+  EXPECT_EQ(obs.value(e11, 4), 25123456.789);
+  EXPECT_EQ(obs.value(e11, 5), 132000000.123);
+  EXPECT_EQ(obs.flag(e11, 5), pack_obs_flags(0, 8));
+
+  int g30 = row_of(obs, 0, "G30");
+  EXPECT_EQ(obs.value(g30, 1), -0.5);
+  EXPECT_EQ(obs.flag(g30, 1), pack_obs_flags(2, 9));
+  EXPECT_EQ(obs.value(g30, 2), 0.0);
+
+  int g05b = row_of(obs, 1, "G05");
+  EXPECT_EQ(obs.value(g05b, 0), 0.0); // blank value
+  EXPECT_EQ(obs.value(g05b, 1), 124121800.001);
+  EXPECT_EQ(obs.flag(g05b, 1), pack_obs_flags(1, 6));
+}
+
+TEST(ParseRinex, V2ContinuationLines) {
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v2.rnx"), obs), ParseRinexError::Success);
+  EXPECT_FALSE(obs.is_v3);
+  EXPECT_EQ(obs.obs_types, (std::vector<std::string>{"C1", "L1", "L2", "P2", "C2", "S1", "S2"}));
+  ASSERT_EQ(obs.num_epochs(), 2u);
+  EXPECT_EQ(obs.epoch_time[1], gps_time_ns(2024, 3, 1, 0, 0, 30.0));
+
+  // 13 satellites: the satellite list and each record wrap onto continuation lines
+  const char* sats[] = {"G01", "G02", "G03", "G04", "G05", "G06", "G07",
+                        "G08", "G09", "G10", "R01", "R02", "E05"};
+  ASSERT_EQ(obs.rows_end(0), 13u);
+  for (int i = 0; i < 13; ++i) {
+    ASSERT_EQ(obs.sats[obs.row_sat[i]], SatId::parse(sats[i]));
+    for (int t = 0; t < 7; ++t) {
+      EXPECT_EQ(obs.value(i, t), v2_value(0, i, t)) << sats[i] << " " << t;
+      EXPECT_EQ(obs.flag(i, t), pack_obs_flags(0, t + 1));
+    }
+  }
+
+  size_t r = obs.rows_begin(1);
+  EXPECT_EQ(obs.value(r, 5), v2_value(2, 0, 5));
+  EXPECT_EQ(obs.value(r, 6), 0.0); // blank last slot of the continuation line
+  EXPECT_EQ(obs.flag(r, 6), 0);
+  EXPECT_EQ(obs.flag(r, 1), pack_obs_flags(1, 2));
+  EXPECT_EQ(obs.flag(r + 1, 2), pack_obs_flags(4, 3));
+}
+
+TEST(ParseRinex, SelectedObsCodes) {
+  ParseOptions opts;
+  opts.obs_codes = {"L1X", "C1C", "XXX"};
+  RinexObs all, sel;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), all), ParseRinexError::Success);
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), sel, opts), ParseRinexError::Success);
+  EXPECT_EQ(sel.obs_types, (std::vector<std::string>{"L1X", "C1C"}));
+  ASSERT_EQ(sel.num_rows(), all.num_rows());
+  for (size_t r = 0; r < sel.num_rows(); ++r) {
+    EXPECT_EQ(sel.value(r, 0), all.value(r, 5));
+    EXPECT_EQ(sel.value(r, 1), all.value(r, 0));
+    EXPECT_EQ(sel.flag(r, 0), all.flag(r, 5));
+  }
+
+  opts.obs_codes = {"XXX"};
+  EXPECT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), sel, opts), ParseRinexError::IncompatibleObsTypes);
+}
+
+TEST(ParseRinex, Errors) {
+  RinexObs obs;
+  EXPECT_EQ(parse_rinex_obs(test::data_path("no_such_file.rnx"), obs), ParseRinexError::FileNotFound);
+
+  std::string text = test::read_file(test::data_path("obs_v3.rnx"));
+  size_t eoh = text.find("END OF HEADER");
+  size_t body = text.find('\n', eoh) + 1;
+
+  std::string no_eoh = test::temp_path("no_eoh.rnx");
+  test::write_file(no_eoh, text.substr(0, text.rfind('\n', eoh) + 1));
+  EXPECT_EQ(parse_rinex_obs(no_eoh, obs), ParseRinexError::MissingHeader);
+
+  std::string header_only = test::temp_path("header_only.rnx");
+  test::write_file(header_only, text.substr(0, body));
+  EXPECT_EQ(parse_rinex_obs(header_only, obs), ParseRinexError::NoEpochs);
+}
+
+TEST(ParseRinex, ChunkedParseMatchesSerial) {
+  for (int version : {2, 3}) {
+    std::string path = generated_file(version, 900);
+    RinexObs serial, chunked;
+    ASSERT_EQ(parse_rinex_obs(path, serial), ParseRinexError::Success);
+    ParseOptions opts;
+    opts.threads = 4;
+    opts.min_chunk_bytes = 64 << 10;
+    ASSERT_EQ(parse_rinex_obs(path, chunked, opts), ParseRinexError::Success);
+    EXPECT_EQ(serial.num_epochs(), 900u);
+    test::expect_same_obs(serial, chunked);
+  }
+}
+
+TEST(ParseRinex, IoThreadStreamsWithoutMapping) {
+  // a pipe cannot be mapped, nor opened twice by one reader; read ahead it parses as is
+  std::string path = test::temp_path("pipe.rnx");
+  ASSERT_EQ(mkfifo(path.c_str(), 0600), 0);
+  std::string text = test::read_file(test::data_path("obs_v3.rnx"));
+  std::thread writer([&]() { test::write_file(path, text); });
+  ParseOptions opts;
+  opts.io_thread = true;
+  RinexObs obs;
+  EXPECT_EQ(parse_rinex_obs(path, obs, opts), ParseRinexError::Success);
+  writer.join();
+  std::remove(path.c_str());
+  RinexObs want;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), want), ParseRinexError::Success);
+  test::expect_same_obs(obs, want);
+}
+
+TEST(ParseRinex, ArenaAllocation) {
+  std::pmr::monotonic_buffer_resource arena;
+  RinexObs in_arena(&arena), plain;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), in_arena), ParseRinexError::Success);
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), plain), ParseRinexError::Success);
+  EXPECT_EQ(in_arena.epoch_time.get_allocator().resource(), &arena);
+  EXPECT_EQ(in_arena.obs[0].get_allocator().resource(), &arena);
+  test::expect_same_obs(in_arena, plain);
+}
+
+TEST(ParseRinex, FixedPointStorage) {
+  ParseOptions opts;
+  opts.fixed_point = true;
+  RinexObs fixed, plain;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), fixed, opts), ParseRinexError::Success);
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), plain), ParseRinexError::Success);
+  EXPECT_TRUE(fixed.fixed_point);
+  EXPECT_TRUE(fixed.obs.empty());
+  ASSERT_EQ(fixed.obs_fixed.size(), plain.obs.size());
+  EXPECT_EQ(fixed.fixed_value(0, 0), 23619095450);
+  EXPECT_EQ(fixed.fixed_value(0, 2), -1234567);
+  for (size_t r = 0; r < plain.num_rows(); ++r) {
+    for (size_t t = 0; t < plain.obs.size(); ++t) {
+      EXPECT_EQ(fixed.fixed_value(r, t), to_fixed_point(plain.value(r, t)));
+    }
+  }
+  test::expect_same_obs(fixed, plain);
+
+  // appending converts between the storages
+  RinexObs mixed = plain;
+  ObsEpoch ep;
+  fixed.epoch(1, ep);
+  mixed.append(ep);
+  EXPECT_EQ(mixed.value(mixed.rows_begin(mixed.num_epochs() - 1), 1), 124121800.001);
+}
+
+TEST(ParseRinex, EpochRoundTrip) {
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v2.rnx"), obs), ParseRinexError::Success);
+  RinexObs copy;
+  static_cast<RinexHeader&>(copy) = obs;
+  copy.reset_columns();
+  ObsEpoch ep;
+  for (size_t e = 0; e < obs.num_epochs(); ++e) {
+    obs.epoch(e, ep);
+    EXPECT_EQ(ep.size(), obs.rows_end(e) - obs.rows_begin(e));
+    copy.append(ep);
+  }
+  test::expect_same_obs(obs, copy);
+}
+
+TEST(ParseRinex, SatelliteArcsAndFlaggedRows) {
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(test::data_path("obs_v3.rnx"), obs), ParseRinexError::Success);
+  int g05 = obs.sat_index(SatId::parse("G05"));
+  ASSERT_GE(g05, 0);
+  EXPECT_EQ(obs.sat_rows(g05), (std::vector<uint32_t>{0, 4}));
+  EXPECT_EQ(obs.sat_index(SatId::parse("G06")), -1);
+  // L1C rows with a possible cycle slip: G05 (twice), R12 and G30
+  EXPECT_EQ(obs.flagged_rows(1, kLliSlipMask), (std::vector<uint32_t>{0, 1, 3, 4}));
+  EXPECT_EQ(obs.flagged_rows(1, kLliLossOfLock), (std::vector<uint32_t>{0, 1, 4}));
+}
@@ -0,0 +1,42 @@
+// ParseStatsTest.cpp
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/ParseStats.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+TEST(ParseStats, CountsFixture) {
+  std::string path = test::data_path("obs_v3.rnx");
+  ParseStats stats;
+  ParseOptions opts;
+  opts.stats = &stats;
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(path, obs, opts), ParseRinexError::Success);
+  std::string text = test::read_file(path);
+  EXPECT_EQ(stats.files, 1u);
+  EXPECT_EQ(stats.bytes, text.size());
+  EXPECT_EQ(stats.text_bytes, text.size());
+  EXPECT_EQ(stats.epochs, 2u);
+  EXPECT_EQ(stats.event_records, 3u);    // the event record and its two COMMENT lines
+  EXPECT_EQ(stats.satellites, 6u);
+  EXPECT_EQ(stats.skipped_satellites, 1u); // C07
+  EXPECT_EQ(stats.dropped_epochs, 0u);
+  EXPECT_GT(stats.header_lines, 0u);
+  EXPECT_EQ(stats.lines, stats.header_lines + 2 + 3 + 7);
+  EXPECT_GT(stats.total_ns, 0);
+
+  ParseStats sum;
+  sum.merge(stats);
+  sum.merge(stats);
+  EXPECT_EQ(sum.epochs, 4u);
+  EXPECT_EQ(sum.total_ns, 2 * stats.total_ns);
+
+  std::string json = stats.to_json();
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_EQ(json.back(), '}');
+  EXPECT_NE(json.find("\"files\":1,"), std::string::npos);
+  EXPECT_NE(json.find("\"epochs\":2,"), std::string::npos);
+}
@@ -0,0 +1,171 @@
+// RinexFollowerTest.cpp
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../include/ParseStats.hpp"
+#include "../include/RinexFollower.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+namespace {
+
+void append_file(const std::string& path, const std::string& text) {
+  std::ofstream f(path, std::ios::binary | std::ios::app);
+  f.write(text.data(), (std::streamsize)text.size());
+}
+
+} // end namespace
+
+TEST(RinexFollower, EmitsEpochsAsTheyComplete) {
+  std::string text = test::read_file(test::data_path("obs_v3.rnx"));
+  std::string path = test::temp_path("growing.rnx");
+  test::write_file(path, "");
+
+  RinexFollower follower;
+  ASSERT_EQ(follower.open(path), ParseRinexError::Success);
+  std::vector<int64_t> times;
+  auto collect = [&](const ObsEpoch& ep) { times.push_back(ep.time); };
+
+  // the header, cut in the middle of a line
+  size_t body = text.find('\n', text.find("END OF HEADER")) + 1;
+  append_file(path, text.substr(0, 100));
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_FALSE(follower.header_ready());
+  append_file(path, text.substr(100, body - 100));
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_TRUE(follower.header_ready());
+  EXPECT_EQ(follower.header().obs_types.size(), 7u);
+  EXPECT_EQ(follower.offset(), body);
+
+  // the first epoch without its last satellite, then the rest of it
+  size_t second = text.find("\n>", body) + 1;
+  size_t cut = text.rfind("G30", second);
+  append_file(path, text.substr(body, cut + 10 - body));
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_TRUE(times.empty());
+  append_file(path, text.substr(cut + 10));
+  EXPECT_TRUE(follower.wait(0));
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_EQ(times, (std::vector<int64_t>{gps_time_ns(2024, 3, 1, 0, 0, 0.0), gps_time_ns(2024, 3, 1, 0, 0, 30.0)}));
+  EXPECT_EQ(follower.epochs(), 2u);
+  EXPECT_EQ(follower.offset(), text.size());
+}
+
+TEST(RinexFollower, CountsEachLineOnce) {
+  std::string path = test::data_path("obs_v3.rnx");
+  std::string text = test::read_file(path);
+  ParseStats want;
+  ParseOptions opts;
+  opts.stats = &want;
+  RinexObs obs;
+  ASSERT_EQ(parse_rinex_obs(path, obs, opts), ParseRinexError::Success);
+
+  // written a few bytes at a time, so that most polls see a partial epoch
+  std::string growing = test::temp_path("growing.rnx");
+  test::write_file(growing, "");
+  ParseStats stats;
+  opts.stats = &stats;
+  RinexFollower follower;
+  ASSERT_EQ(follower.open(growing, opts), ParseRinexError::Success);
+  for (size_t pos = 0; pos < text.size(); pos += 37) {
+    append_file(growing, text.substr(pos, 37));
+    ASSERT_EQ(follower.poll([](const ObsEpoch&) {}), ParseRinexError::Success);
+  }
+  EXPECT_EQ(follower.epochs(), 2u);
+  EXPECT_EQ(stats.files, 1u);
+  EXPECT_EQ(stats.bytes, want.bytes);
+  EXPECT_EQ(stats.lines, want.lines);
+  EXPECT_EQ(stats.header_lines, want.header_lines);
+  EXPECT_EQ(stats.epochs, want.epochs);
+  EXPECT_EQ(stats.event_records, want.event_records);
+  EXPECT_EQ(stats.satellites, want.satellites);
+  EXPECT_EQ(stats.skipped_satellites, want.skipped_satellites);
+  EXPECT_EQ(stats.fields_decoded, want.fields_decoded);
+  EXPECT_EQ(stats.dropped_epochs, 0u);
+  EXPECT_EQ(stats.stray_lines, 0u);
+}
+
+TEST(RinexFollower, RestartsOnTruncatedFile) {
+  std::string text = test::read_file(test::data_path("obs_v2.rnx"));
+  std::string path = test::temp_path("rewritten.rnx");
+  test::write_file(path, text);
+
+  RinexFollower follower;
+  ASSERT_EQ(follower.open(path), ParseRinexError::Success);
+  size_t n = 0;
+  ASSERT_EQ(follower.poll([&](const ObsEpoch&) { ++n; }), ParseRinexError::Success);
+  EXPECT_EQ(n, 2u);
+
+  // truncated and written again from the start, with the header and first epoch only
+  test::write_file(path, text.substr(0, text.find(" 24  3  1  0  0 15")));
+  std::vector<int> nsv;
+  auto collect = [&](const ObsEpoch& ep) { nsv.push_back((int)ep.size()); };
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Restarted);
+  EXPECT_TRUE(nsv.empty());
+  EXPECT_FALSE(follower.header_ready());
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_EQ(nsv, std::vector<int>{13});
+}
+
+TEST(RinexFollower, RestartsOnRewrittenFile) {
+  std::string text = test::read_file(test::data_path("obs_v2.rnx"));
+  std::string path = test::temp_path("rewritten.rnx");
+  test::write_file(path, text);
+
+  RinexFollower follower;
+  ASSERT_EQ(follower.open(path), ParseRinexError::Success);
+  std::vector<int64_t> times;
+  auto collect = [&](const ObsEpoch& ep) { times.push_back(ep.time); };
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  ASSERT_EQ(times.size(), 2u);
+
+  // overwritten in place with as many bytes, the epochs an hour later
+  std::string later = text;
+  const std::string hour0 = " 24  3  1  0  0", hour1 = " 24  3  1  1  0";
+  for (size_t pos = later.find(hour0); pos != std::string::npos; pos = later.find(hour0, pos)) {
+    later.replace(pos, hour0.size(), hour1);
+  }
+  ASSERT_EQ(later.size(), text.size());
+  test::write_file(path, later);
+  // a second later, as the timestamp may not have moved on since the first write
+  struct stat st;
+  ASSERT_EQ(stat(path.c_str(), &st), 0);
+  struct timespec times_set[2] = {st.st_atim, st.st_mtim};
+  times_set[1].tv_sec += 1;
+  ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times_set, 0), 0);
+  // only hashed again once it stays modified without growing over two polls
+  times.clear();
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Restarted);
+  EXPECT_TRUE(times.empty());
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_EQ(times, (std::vector<int64_t>{gps_time_ns(2024, 3, 1, 1, 0, 0.0), gps_time_ns(2024, 3, 1, 1, 0, 30.0)}));
+
+  // replaced by a larger file renamed over it
+  std::string next = test::temp_path("next.rnx");
+  test::write_file(next, text + text.substr(text.find(" 24  3  1  0  0 15")));
+  ASSERT_EQ(std::rename(next.c_str(), path.c_str()), 0);
+  EXPECT_TRUE(follower.wait(0));
+  times.clear();
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Restarted);
+  ASSERT_EQ(follower.poll(collect), ParseRinexError::Success);
+  EXPECT_EQ(times.size(), 3u);
+  EXPECT_EQ(follower.offset(), text.size() + text.size() - text.find(" 24  3  1  0  0 15"));
+}
+
+TEST(RinexFollower, RejectsCompressedFiles) {
+  std::string path = test::temp_path("compressed.rnx.gz");
+  test::write_file(path, std::string("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\x03", 10) + std::string(200, 'x') + "\n");
+  RinexFollower follower;
+  ASSERT_EQ(follower.open(path), ParseRinexError::Success);
+  EXPECT_EQ(follower.poll([](const ObsEpoch&) {}), ParseRinexError::UnsupportedFormat);
+  EXPECT_EQ(follower.open(test::data_path("no_such_file.rnx")), ParseRinexError::FileNotFound);
+}
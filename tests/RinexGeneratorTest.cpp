@@ -0,0 +1,32 @@
+// RinexGeneratorTest.cpp
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "RinexGenerator.hpp"
+#include "TestData.hpp"
+
+using namespace rinex;
+
+TEST(RinexGenerator, DatesRollOverIntoLaterMonths) {
+  for (int version : {2, 3}) {
+    bench::GeneratorOptions g;
+    g.version = version;
+    g.interval = 86400.0 / 4;
+    g.duration = 60 * 86400.0; // into March, across February 29
+    g.num_sats = 3;
+    std::string path = test::temp_path("generated.rnx");
+    ASSERT_TRUE(bench::write_rinex(path, g));
+
+    RinexObs obs;
+    ASSERT_EQ(parse_rinex_obs(path, obs), ParseRinexError::Success);
+    ASSERT_EQ(obs.num_epochs(), 240u) << version;
+    int64_t t0 = gps_time_ns(2024, 1, 15, 0, 0, 0.0);
+    for (size_t e = 0; e < obs.num_epochs(); ++e) {
+      ASSERT_EQ(obs.epoch_time[e], t0 + (int64_t)e * kNsPerDay / 4) << "epoch " << e;
+    }
+    CalendarTime last = obs.epoch_calendar(obs.num_epochs() - 1);
+    EXPECT_EQ(last.month, 3);
+    EXPECT_EQ(last.day, 14);
+  }
+}
@@ -0,0 +1,48 @@
+// SatIdTest.cpp
+#include <set>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+#include "../include/SatId.hpp"
+
+using namespace rinex;
+
+TEST(SatId, ParsesRinex2And3Forms) {
+  EXPECT_EQ(SatId::parse("G05"), SatId(GnssSystem::GPS, 5));
+  EXPECT_EQ(SatId::parse("G 5"), SatId(GnssSystem::GPS, 5));
+  EXPECT_EQ(SatId::parse(" 5"), SatId(GnssSystem::GPS, 5));
+  EXPECT_EQ(SatId::parse("05"), SatId(GnssSystem::GPS, 5));
+  EXPECT_EQ(SatId::parse("R12"), SatId(GnssSystem::GLONASS, 12));
+  EXPECT_EQ(SatId::parse("E30").system(), GnssSystem::Galileo);
+  EXPECT_EQ(SatId::parse("C07").system(), GnssSystem::BeiDou);
+  EXPECT_EQ(SatId::parse("J01").system(), GnssSystem::QZSS);
+  EXPECT_EQ(SatId::parse("I02").system(), GnssSystem::IRNSS);
+  EXPECT_EQ(SatId::parse("S20").system(), GnssSystem::SBAS);
+
+  EXPECT_FALSE(SatId::parse("").valid());
+  EXPECT_FALSE(SatId::parse("X05").valid());
+  EXPECT_FALSE(SatId::parse("G00").valid());
+  EXPECT_FALSE(SatId::parse("G123").valid());
+  EXPECT_FALSE(SatId::parse("G0a").valid());
+}
+
+TEST(SatId, FormatsAsRinex3) {
+  EXPECT_EQ(SatId(GnssSystem::GPS, 5).to_string(), "G05");
+  EXPECT_EQ(SatId::parse("R 7").to_string(), "R07");
+  EXPECT_EQ(SatId(GnssSystem::Galileo, 30).letter(), 'E');
+}
+
+TEST(SatId, DenseUniqueIndex) {
+  std::set<size_t> seen;
+  std::unordered_set<SatId> hashed;
+  for (size_t s = 1; s < kNumSystems; ++s) {
+    for (int prn = 1; prn < SatId::kMaxPrn; ++prn) {
+      SatId sv((GnssSystem)s, prn);
+      ASSERT_LT(sv.index(), SatId::kIndexCount);
+      EXPECT_TRUE(seen.insert(sv.index()).second) << sv.to_string();
+      hashed.insert(sv);
+    }
+  }
+  EXPECT_EQ(hashed.size(), seen.size());
+}
@@ -0,0 +1,62 @@
+// TestData.hpp
+#pragma once
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../include/ParseRinex.hpp"
+
+namespace rinex {
+namespace test {
+
+// checked-in fixture under tests/data
+inline std::string data_path(const std::string& name) {
+  return std::string(RINEX_TEST_DATA) + "/" + name;
+}
+
+// a scratch file for the running test, removed first if it exists; the process id keeps
+// test binaries run side by side (ctest -j) apart
+inline std::string temp_path(const std::string& name) {
+  const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+  std::string path = ::testing::TempDir() + "rinex_" + std::to_string(getpid()) + "_" + info->test_suite_name() +
+                     "_" + info->name() + "_" + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+inline std::string read_file(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+inline void write_file(const std::string& path, const std::string& text) {
+  std::ofstream f(path, std::ios::binary | std::ios::trunc);
+  f.write(text.data(), (std::streamsize)text.size());
+}
+
+// same epochs, satellites, values and flags, in either storage
+inline void expect_same_obs(const RinexObs& a, const RinexObs& b) {
+  ASSERT_EQ(a.obs_types, b.obs_types);
+  ASSERT_EQ(a.num_epochs(), b.num_epochs());
+  ASSERT_EQ(a.num_rows(), b.num_rows());
+  for (size_t e = 0; e < a.num_epochs(); ++e) {
+    ASSERT_EQ(a.epoch_time[e], b.epoch_time[e]) << "epoch " << e;
+    ASSERT_EQ(a.epoch_flag[e], b.epoch_flag[e]) << "epoch " << e;
+    ASSERT_EQ(a.rows_begin(e), b.rows_begin(e)) << "epoch " << e;
+  }
+  for (size_t r = 0; r < a.num_rows(); ++r) {
+    ASSERT_EQ(a.sats[a.row_sat[r]], b.sats[b.row_sat[r]]) << "row " << r;
+    for (size_t t = 0; t < a.obs_types.size(); ++t) {
+      ASSERT_EQ(a.value(r, t), b.value(r, t)) << "row " << r << " type " << a.obs_types[t];
+      ASSERT_EQ(a.flag(r, t), b.flag(r, t)) << "row " << r << " type " << a.obs_types[t];
+    }
+  }
+}
+
+} // end namespace test
+} // end namespace rinex